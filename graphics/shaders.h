@@ -1,3 +1,3 @@
-#pragma once
-
-void loadShaderLibraries();
+#pragma once
+
+void loadShaderLibraries();
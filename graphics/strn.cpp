@@ -1,11 +1,11 @@
-#include "strn.h"
-
-#include <cstdio>
-#include <cstdarg>
-#include <cstdlib>
-#include <cstring>
-
-MYGLSTRNFUNCS(24)
-MYGLSTRNFUNCS(40)
-MYGLSTRNFUNCS(64)
-MYGLSTRNFUNCS(80)
+#include "strn.h"
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+
+MYGLSTRNFUNCS(24)
+MYGLSTRNFUNCS(40)
+MYGLSTRNFUNCS(64)
+MYGLSTRNFUNCS(80)
@@ -0,0 +1,408 @@
+#include "bvh.h"
+#include "../../utils/log.h"
+#include "../simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mbz::math;
+using namespace mbz::math::bpcd;
+
+namespace {
+
+float surfaceArea(const Vector3 &min, const Vector3 &max) {
+  Vector3 e = max - min;
+  return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+void grow(Vector3 &min, Vector3 &max, const Vector3 &p) {
+  for (int i = 0; i < 3; i++) {
+    min.xyz[i] = std::min(min.xyz[i], p.xyz[i]);
+    max.xyz[i] = std::max(max.xyz[i], p.xyz[i]);
+  }
+}
+
+bool hitsNode(const Bvh::Node &node, const Vector3 &o, const Vector3 &inv, float dist) {
+  float t0 = 0.0f;
+  float t1 = dist;
+  for (int i = 0; i < 3; i++) {
+    float tNear = (node.min[i] - o.xyz[i]) * inv.xyz[i];
+    float tFar = (node.max[i] - o.xyz[i]) * inv.xyz[i];
+    if (tNear > tFar)
+      std::swap(tNear, tFar);
+    t0 = std::max(t0, tNear);
+    t1 = std::min(t1, tFar);
+    if (t0 > t1)
+      return false;
+  }
+  return true;
+}
+
+}
+
+bool Bvh::build(const TriangleView &trisPoints) {
+  nodes.clear();
+  tris.clear();
+  int n = int(trisPoints.size());
+  if (!n)
+    return false;
+
+  std::vector<Ref> refs(n);
+  Vector3 min = trisPoints[0][0];
+  Vector3 max = trisPoints[0][0];
+  for (int i = 0; i < n; i++) {
+    Ref &ref = refs[i];
+    ref.index = i;
+    ref.min = ref.max = trisPoints[i][0];
+    grow(ref.min, ref.max, trisPoints[i][1]);
+    grow(ref.min, ref.max, trisPoints[i][2]);
+    ref.centroid = 0.5f * (ref.min + ref.max);
+    grow(min, max, ref.min);
+    grow(min, max, ref.max);
+  }
+  bigBox = Aabb(0.5f * (min + max), 0.5f * (max - min));
+
+  // a binary tree over n leaves never needs more than 2n - 1 nodes
+  nodes.reserve(2 * n);
+  buildNode(refs, 0, n, 0);
+
+  tris.resize(n);
+  for (int i = 0; i < n; i++) {
+    const auto &points = trisPoints[refs[i].index];
+    tris[i].init(points[0], points[1], points[2], refs[i].index);
+  }
+
+  LOGINFO("Bvh::build()", "%d triangles, %zu nodes (%.2f kbs)", n, nodes.size(), float(nodes.size() * sizeof(Node)) / 1024.0f);
+  return true;
+}
+
+int Bvh::buildNode(std::vector<Ref> &refs, int begin, int end, int depth) {
+  int index = int(nodes.size());
+  nodes.emplace_back();
+
+  Vector3 min = refs[begin].min;
+  Vector3 max = refs[begin].max;
+  Vector3 cMin = refs[begin].centroid;
+  Vector3 cMax = refs[begin].centroid;
+  for (int i = begin; i < end; i++) {
+    grow(min, max, refs[i].min);
+    grow(min, max, refs[i].max);
+    grow(cMin, cMax, refs[i].centroid);
+  }
+  for (int i = 0; i < 3; i++) {
+    nodes[index].min[i] = min.xyz[i];
+    nodes[index].max[i] = max.xyz[i];
+  }
+
+  int count = end - begin;
+  auto makeLeaf = [&]() {
+    nodes[index].offset = begin;
+    nodes[index].count = uint16_t(count);
+    nodes[index].axis = 0;
+    return index;
+  };
+  if (count <= 1)
+    return makeLeaf();
+
+  // binned SAH: traversal cost and intersection cost are both taken as 1
+  int bestAxis = -1;
+  int bestSplit = 0;
+  float bestCost = INFINITY;
+  float invArea = 1.0f / std::max(surfaceArea(min, max), math::tol);
+  if (depth < maxDepth) {
+    for (int axis = 0; axis < 3; axis++) {
+      float extent = cMax.xyz[axis] - cMin.xyz[axis];
+      if (extent <= math::tol)
+        continue;
+      float scale = float(numBins) / extent;
+
+      int binCounts[numBins] = { 0 };
+      Vector3 binMins[numBins], binMaxs[numBins];
+      for (int i = begin; i < end; i++) {
+        int b = std::min(numBins - 1, int((refs[i].centroid.xyz[axis] - cMin.xyz[axis]) * scale));
+        if (!binCounts[b]) {
+          binMins[b] = refs[i].min;
+          binMaxs[b] = refs[i].max;
+        } else {
+          grow(binMins[b], binMaxs[b], refs[i].min);
+          grow(binMins[b], binMaxs[b], refs[i].max);
+        }
+        binCounts[b]++;
+      }
+
+      float leftAreas[numBins], rightAreas[numBins];
+      int leftCounts[numBins], rightCounts[numBins];
+      Vector3 lMin, lMax, rMin, rMax;
+      int lCount = 0, rCount = 0;
+      for (int i = 0; i < numBins - 1; i++) {
+        if (binCounts[i]) {
+          if (!lCount) {
+            lMin = binMins[i];
+            lMax = binMaxs[i];
+          } else {
+            grow(lMin, lMax, binMins[i]);
+            grow(lMin, lMax, binMaxs[i]);
+          }
+          lCount += binCounts[i];
+        }
+        leftCounts[i] = lCount;
+        leftAreas[i] = lCount ? surfaceArea(lMin, lMax) : 0.0f;
+
+        int j = numBins - 1 - i;
+        if (binCounts[j]) {
+          if (!rCount) {
+            rMin = binMins[j];
+            rMax = binMaxs[j];
+          } else {
+            grow(rMin, rMax, binMins[j]);
+            grow(rMin, rMax, binMaxs[j]);
+          }
+          rCount += binCounts[j];
+        }
+        rightCounts[j] = rCount;
+        rightAreas[j] = rCount ? surfaceArea(rMin, rMax) : 0.0f;
+      }
+
+      // split s puts bins [0, s) on the left and [s, numBins) on the right
+      for (int s = 1; s < numBins; s++) {
+        if (!leftCounts[s - 1] || !rightCounts[s])
+          continue;
+        float cost = 1.0f + (leftAreas[s - 1] * float(leftCounts[s - 1]) + rightAreas[s] * float(rightCounts[s])) * invArea;
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestSplit = s;
+        }
+      }
+    }
+  }
+
+  int mid = begin;
+  if (bestAxis >= 0) {
+    if (bestCost >= float(count) && count <= maxLeafSize)
+      return makeLeaf();
+    float scale = float(numBins) / (cMax.xyz[bestAxis] - cMin.xyz[bestAxis]);
+    auto it = std::partition(refs.begin() + begin, refs.begin() + end, [&](const Ref &ref) {
+      int b = std::min(numBins - 1, int((ref.centroid.xyz[bestAxis] - cMin.xyz[bestAxis]) * scale));
+      return b < bestSplit;
+    });
+    mid = int(it - refs.begin());
+  } else {
+    if (count <= maxLeafSize)
+      return makeLeaf();
+    // coincident centroids (or too deep for SAH to help), fall back to a median split
+    Vector3 extent = cMax - cMin;
+    bestAxis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+  }
+  if (mid == begin || mid == end) {
+    mid = (begin + end) / 2;
+    std::nth_element(refs.begin() + begin, refs.begin() + mid, refs.begin() + end, [&](const Ref &a, const Ref &b) {
+      return a.centroid.xyz[bestAxis] < b.centroid.xyz[bestAxis];
+    });
+  }
+
+  nodes[index].count = 0;
+  nodes[index].axis = uint16_t(bestAxis);
+  buildNode(refs, begin, mid, depth + 1);
+  int second = buildNode(refs, mid, end, depth + 1);
+  nodes[index].offset = second;
+  return index;
+}
+
+bool Bvh::traceRay(RaySeg raySeg, Trace &trace) const {
+  trace.raySeg = raySeg;
+  trace.bcsCoord = std::nullopt;
+  trace.point = std::nullopt;
+  if (nodes.empty() || raySeg.dist <= 0.0f)
+    return false;
+
+  Vector3 inv;
+  bool negative[3];
+  for (int i = 0; i < 3; i++) {
+    float d = raySeg.d.xyz[i];
+    inv.xyz[i] = fabsf(d) > math::tol ? 1.0f / d : (d < 0.0f ? -1e30f : 1e30f);
+    negative[i] = d < 0.0f;
+  }
+
+  RaySeg seg = raySeg;
+  WatertightRay ray(raySeg);
+  bool hit = false;
+  int stack[128];
+  int top = 0;
+  int current = 0;
+  while (true) {
+    const Node &node = nodes[current];
+    if (hitsNode(node, seg.p, inv, seg.dist)) {
+      if (!node.leaf()) {
+        // visit the near child first so the far one is likely culled by a shorter segment
+        if (negative[node.axis]) {
+          stack[top++] = current + 1;
+          current = node.offset;
+        } else {
+          stack[top++] = node.offset;
+          current = current + 1;
+        }
+        continue;
+      }
+      for (int i = node.offset; i < node.offset + node.count; i++) {
+        float t;
+        BcsCoord coord;
+        if (!tris[i].intersect(ray, t, coord))
+          continue;
+        trace.index = tris[i].index;
+        trace.bcsCoord = coord;
+        trace.point = seg.p + t * seg.d;
+        seg.dist = ray.dist = t;
+        hit = true;
+      }
+    }
+    if (!top)
+      break;
+    current = stack[--top];
+  }
+  if (hit)
+    trace.raySeg = seg;
+  return trace();
+}
+
+bool Bvh::occluded(const RaySeg &raySeg) const {
+  if (nodes.empty() || raySeg.dist <= 0.0f)
+    return false;
+
+  Vector3 inv;
+  for (int i = 0; i < 3; i++) {
+    float d = raySeg.d.xyz[i];
+    inv.xyz[i] = fabsf(d) > math::tol ? 1.0f / d : (d < 0.0f ? -1e30f : 1e30f);
+  }
+
+  WatertightRay ray(raySeg);
+  int stack[128];
+  int top = 0;
+  int current = 0;
+  while (true) {
+    const Node &node = nodes[current];
+    if (hitsNode(node, raySeg.p, inv, raySeg.dist)) {
+      if (!node.leaf()) {
+        stack[top++] = node.offset;
+        current = current + 1;
+        continue;
+      }
+      for (int i = node.offset; i < node.offset + node.count; i++) {
+        if (tris[i].hits(ray))
+          return true;
+      }
+    }
+    if (!top)
+      break;
+    current = stack[--top];
+  }
+  return false;
+}
+
+uint32_t Bvh::occluded(const RayPacket &packet) const {
+  using simd::Float;
+  constexpr int W = simd::width;
+  uint32_t active = packet.mask();
+  if (nodes.empty() || !active)
+    return 0;
+
+  alignas(32) float invX[RayPacket::maxSize], invY[RayPacket::maxSize], invZ[RayPacket::maxSize];
+  for (int i = 0; i < RayPacket::maxSize; i++) {
+    auto inverse = [](float d) {
+      return fabsf(d) > math::tol ? 1.0f / d : (d < 0.0f ? -1e30f : 1e30f);
+    };
+    invX[i] = inverse(packet.dx[i]);
+    invY[i] = inverse(packet.dy[i]);
+    invZ[i] = inverse(packet.dz[i]);
+  }
+  int chunks = (packet.size + W - 1) / W;
+
+  // lanes whose segment overlaps the node's box
+  auto hitsNodeLanes = [&](const Node &node) {
+    Float minX(node.min[0]), minY(node.min[1]), minZ(node.min[2]);
+    Float maxX(node.max[0]), maxY(node.max[1]), maxZ(node.max[2]);
+    uint32_t lanes = 0;
+    for (int c = 0; c < chunks; c++) {
+      int k = c * W;
+      Float t0(0.0f);
+      Float t1 = Float::load(packet.dist + k);
+      Float o = Float::load(packet.ox + k), inv = Float::load(invX + k);
+      Float tn = (minX - o) * inv, tf = (maxX - o) * inv;
+      t0 = simd::max(t0, simd::min(tn, tf));
+      t1 = simd::min(t1, simd::max(tn, tf));
+      o = Float::load(packet.oy + k);
+      inv = Float::load(invY + k);
+      tn = (minY - o) * inv;
+      tf = (maxY - o) * inv;
+      t0 = simd::max(t0, simd::min(tn, tf));
+      t1 = simd::min(t1, simd::max(tn, tf));
+      o = Float::load(packet.oz + k);
+      inv = Float::load(invZ + k);
+      tn = (minZ - o) * inv;
+      tf = (maxZ - o) * inv;
+      t0 = simd::max(t0, simd::min(tn, tf));
+      t1 = simd::min(t1, simd::max(tn, tf));
+      lanes |= simd::mask(t0 <= t1) << k;
+    }
+    return lanes;
+  };
+
+  // the unsheared triple products of every lane only pick candidates, with a relative slack
+  // wide enough to cover how they round differently from the sheared edge functions.
+  // candidates then take Triangle::hits, so each lane gets exactly the scalar any-hit answer,
+  // watertight edges included
+  WatertightRay rays[RayPacket::maxSize];
+  for (int lane = 0; lane < packet.size; lane++)
+    rays[lane] = WatertightRay(packet.get(lane));
+  auto hitsTriLanes = [&](const Triangle &tri, uint32_t open) {
+    Float v0x(tri.v0.x), v0y(tri.v0.y), v0z(tri.v0.z);
+    Float v1x(tri.v1.x), v1y(tri.v1.y), v1z(tri.v1.z);
+    Float v2x(tri.v2.x), v2y(tri.v2.y), v2z(tri.v2.z);
+    Float zero(0.0f), slack(-1e-3f);
+    uint32_t candidates = 0;
+    for (int c = 0; c < chunks; c++) {
+      int k = c * W;
+      Float ox = Float::load(packet.ox + k), oy = Float::load(packet.oy + k), oz = Float::load(packet.oz + k);
+      Float dx = Float::load(packet.dx + k), dy = Float::load(packet.dy + k), dz = Float::load(packet.dz + k);
+      Float ax = v0x - ox, ay = v0y - oy, az = v0z - oz;
+      Float bx = v1x - ox, by = v1y - oy, bz = v1z - oz;
+      Float cx = v2x - ox, cy = v2y - oy, cz = v2z - oz;
+      Float u = dx * (cy * bz - cz * by) + dy * (cz * bx - cx * bz) + dz * (cx * by - cy * bx);
+      Float v = dx * (ay * cz - az * cy) + dy * (az * cx - ax * cz) + dz * (ax * cy - ay * cx);
+      Float w = dx * (by * az - bz * ay) + dy * (bz * ax - bx * az) + dz * (bx * ay - by * ax);
+      Float e = slack * (simd::max(u, zero - u) + simd::max(v, zero - v) + simd::max(w, zero - w));
+      candidates |= simd::mask((u >= e) & (v >= e) & (w >= e)) << k;
+    }
+    uint32_t lanes = 0;
+    candidates &= open;
+    for (int lane = 0; candidates >> lane; lane++) {
+      if ((candidates >> lane & 1u) && tri.hits(rays[lane]))
+        lanes |= 1u << lane;
+    }
+    return lanes;
+  };
+
+  uint32_t hits = 0;
+  int stack[128];
+  int top = 0;
+  int current = 0;
+  while (true) {
+    const Node &node = nodes[current];
+    if (hitsNodeLanes(node) & active & ~hits) {
+      if (!node.leaf()) {
+        stack[top++] = node.offset;
+        current = current + 1;
+        continue;
+      }
+      for (int i = node.offset; i < node.offset + node.count; i++) {
+        hits |= hitsTriLanes(tris[i], active & ~hits);
+        if (hits == active)
+          return hits;
+      }
+    }
+    if (!top)
+      break;
+    current = stack[--top];
+  }
+  return hits;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../bcs.h"
+#include "tracer.h"
+#include "triangle.h"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace mbz {
+namespace math {
+namespace bpcd {
+
+// bounding volume hierarchy built with a binned surface area heuristic. nodes are
+// flattened depth first, so the first child of an interior node always follows it
+// and only the second child needs an offset.
+struct Bvh : public Tracer {
+  static constexpr int numBins = 12;
+  static constexpr int maxLeafSize = 8;
+  static constexpr int maxDepth = 64;
+
+  struct Node {
+    float min[3];
+    int offset;  // leaf: first triangle, interior: index of the second child
+    float max[3];
+    uint16_t count;  // triangles in a leaf, 0 for interior nodes
+    uint16_t axis;  // split axis of an interior node
+    bool leaf() const {
+      return count > 0;
+    }
+  };
+  static_assert(sizeof(Node) == 32, "Bvh::Node should fill half a cache line");
+
+  std::vector<Node> nodes;
+  std::vector<Triangle> tris;  // leaf order, Triangle::index is the source triangle
+  Aabb bigBox;
+
+  Bvh() = default;
+
+  bool build(const TriangleView &trisPoints);
+
+  virtual bool traceRay(RaySeg raySeg, Trace &trace) const override;
+  virtual bool occluded(const RaySeg &raySeg) const override;
+  virtual uint32_t occluded(const RayPacket &packet) const override;
+
+  virtual Aabb bounds() const override {
+    return bigBox;
+  }
+
+ protected:
+  struct Ref {
+    Vector3 min, max, centroid;
+    int index;
+  };
+  int buildNode(std::vector<Ref> &refs, int begin, int end, int depth);
+};
+
+}
+}
+}
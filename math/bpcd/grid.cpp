@@ -1,204 +1,690 @@
-#include "grid.h"
-#include "../../utils/log.h"
-
-using namespace mbz::math;
-using namespace mbz::math::bpcd;
-using namespace mbz::utils::logger;
-using namespace mbz::utils::heap;
-
-uint32_t Grid::getHashOf(int l, int r, int c) {
-  uint32_t hash = hasher<int>(hasher(), l);
-  hash = hasher<int>(hash, r);
-  hash = hasher<int>(hash, c);
-  return hash;
-}
-
-void Grid::getBoxes(std::vector<Aabb> &boxes) {
-  boxes.clear();
-  int n;
-  Heap::Tile *tile = cells.getList(n);
-  Hashmap<Cell>::Container *list = tile->p<Hashmap<Cell>::Container>();
-  for (int i = 0; i < n; i++) {
-    boxes.push_back((list[i])()->aabb);
-  }
-  heap->release(tile);
-}
-
-bool Grid::build(const std::vector<std::array<Vector3, 3>> &trisPoints, Vector3 cellSize) {
-  int n = int(trisPoints.size());
-  Vector3 min = trisPoints[0][0];
-  Vector3 max = trisPoints[0][0];
-  for (int i = 0; i < n; i++) {
-    Bcs3 bcs;
-    bcs.init(trisPoints[i][0], trisPoints[i][1], trisPoints[i][2]);
-    tris.append(bcs);
-    for (int j = 0; j < 3; j++) {
-      min.x = std::min(min.x, trisPoints[i][j].x);
-      max.x = std::max(max.x, trisPoints[i][j].x);
-
-      min.y = std::min(min.y, trisPoints[i][j].y);
-      max.y = std::max(max.y, trisPoints[i][j].y);
-
-      min.z = std::min(min.z, trisPoints[i][j].z);
-      max.z = std::max(max.z, trisPoints[i][j].z);
-    }
-  }
-  bigBox.fromExtents(min, max);
-  o = bigBox.minExtent();
-  LOGINFO("Grid::build()", "Extents: {%.4f, %.4f, %.4f} / {%.4f, %.4f, %.4f}", min.x, min.y, min.z, max.x, max.y, max.z);
-  LOGINFO("Grid::build()", "Origin.: {%.4f, %.4f, %.4f}", o.x, o.y, o.z);
-  this->cellSize = cellSize;
-
-  int index = 0;
-  for (auto &triPoints : trisPoints) {
-    int l1, l2, l3, lRange[2];
-    int r1, r2, r3, rRange[2];
-    int c1, c2, c3, cRange[2];
-    getCellForPoint(triPoints[0], l1, r1, c1);
-    getCellForPoint(triPoints[1], l2, r2, c2);
-    getCellForPoint(triPoints[2], l3, r3, c3);
-    lRange[0] = std::min(l1, std::min(l2, l3)) - 1;
-    rRange[0] = std::min(r1, std::min(r2, r3)) - 1;
-    cRange[0] = std::min(c1, std::min(c2, c3)) - 1;
-    lRange[1] = std::max(l1, std::max(l2, l3)) + 1;
-    rRange[1] = std::max(r1, std::max(r2, r3)) + 1;
-    cRange[1] = std::max(c1, std::max(c2, c3)) + 1;
-
-    //printf("levels.: %d - %d\n", lRange[0], lRange[1]);
-    //printf("rows...: %d - %d\n", rRange[0], rRange[1]);
-    //printf("columns: %d - %d\n", cRange[0], cRange[1]);
-
-    for (int l = lRange[0]; l <= lRange[1]; l++) {
-      for (int r = rRange[0]; r <= rRange[1]; r++) {
-        for (int c = cRange[0]; c <= cRange[1]; c++) {
-          Aabb aabb = cellBox(l, r, c);
-          Sphere sphere(aabb.p, aabb.halfSize.lengthSq());
-          Sphere sphere2(triPoints);
-          if (!sphere.touches(sphere2))
-            continue;
-          if(!aabb.intersects(triPoints))
-            continue;
-
-          //if (!aabb.collidesWith(triPoints))
-          //  continue;
-          Cell *cell = cells.insertIf(Cell(l, r, c, aabb, heap));
-          cell->triIndices.append(index);
-        }
-      }
-    }
-    index++;
-  }
-
-//  Hashmap<Cell>::E *elems = cells.pool->p<Hashmap<Cell>::E>();
-//  for (uint32_t i = 0; i < cells.tableSize; i++) {
-//    if (!elems[i].data)
-//      continue;
-//
-//  }
-
-  return true;
-}
-
-bool Grid::traceRay(RaySeg raySeg, Trace &trace, std::optional<std::reference_wrapper<std::vector<std::array<int, 3>>>> indices) const {
-
-  trace.raySeg = raySeg;
-  trace.bcsCoord = std::nullopt;
-  trace.point = std::nullopt;
-  for (int i = 0; i < 3; i++) {
-    if (fabsf(raySeg.d.xyz[i]) < math::tol)
-      raySeg.d.xyz[i] = 0.0f;
-  }
-  if (indices.has_value())
-    indices->get().clear();
-
-  int l, r, c;
-  Vector3 o = raySeg.p;
-  Vector3 p = o;
-  getCellForPoint(raySeg.p, l, r, c);
-  auto d = raySeg.d;
-
-  int dl = d.z < -math::tol ? -1 : d.z > math::tol ? +1 : 0;
-  int dr = d.y < -math::tol ? -1 : d.y > math::tol ? +1 : 0;
-  int dc = d.x < -math::tol ? -1 : d.x > math::tol ? +1 : 0;
-
-  auto march = [&](float &distLeft) {
-    if (indices.has_value())
-      indices->get().push_back( { l, r, c });
-    auto box = cellBox(l, r, c);
-    Vector3 min = box.minExtent();
-    Vector3 max = box.maxExtent();
-
-    Vector3 dist;
-    for (int i = 0; i < 3; i++) {
-      if (d.xyz[i] >= math::tol) {
-        dist.xyz[i] = (max.xyz[i] - p.xyz[i]) / d.xyz[i];
-      } else if (d.xyz[i] <= math::tol) {
-        dist.xyz[i] = (min.xyz[i] - p.xyz[i]) / d.xyz[i];
-      } else
-        dist.xyz[i] = INFINITY;
-    }
-    float shortest = std::min(dist.x, std::min(dist.y, dist.z));
-    shortest = std::min(shortest, distLeft);
-    Vector3 p2 = p + shortest * d;
-    auto cell = cells.kcontains(getHashOf(l, r, c));
-    if (cell) {
-      bool hit = false;
-      Vector3 e = p2;
-      for (int i = 0; i < cell->triIndices.size; i++) {
-        RaySeg seg(o, e);
-        int j = cell->triIndices.kp()[i];
-        const auto &bcs = tris.kp()[j];
-        auto coord = bcs.project(seg);
-        if (coord.has_value()) {
-          trace.index = j;
-          trace.bcsCoord = coord;
-          trace.point = bcs.o + coord->x * bcs.u + coord->y * bcs.v;
-          trace.raySeg = seg;
-          hit = true;
-          e = trace.point.value();
-        }
-      }
-      if (hit) {
-        return false;
-      }
-    }
-    distLeft -= shortest;
-    if (distLeft == 0.0f)
-      return false;
-
-    p = p2;
-    if (dist.x == shortest)
-      c += dc;
-    if (dist.y == shortest)
-      r += dr;
-    if (dist.z == shortest)
-      l += dl;
-    return true;
-  };
-
-  Vector3 u = raySeg.end() - raySeg.p;
-  if (fabsf(u.x) < math::tol && fabsf(u.y) < math::tol && fabsf(u.z) < math::tol)
-    return false;
-
-  float dist = raySeg.dist;
-  for (int i = 0; i < 500; i++)
-    if (!march(dist))
-      break;
-
-  return trace();
-  /*
-  bool hit = false;
-  for (int i = 0; i < tris.size; i++) {
-    auto bcs = tris.kp()[i];
-    auto coord = bcs.project(raySeg);
-    if (coord.has_value()) {
-      trace.index = i;
-      trace.bcsCoord = coord;
-      trace.point = bcs.o + coord->x * bcs.u + coord->y * bcs.v;
-      raySeg.dist = raySeg.p.point(*trace.point).dot(raySeg.d);
-      hit = true;
-    }
-  }
-  return hit;
-  */
-}
+#include "grid.h"
+#include "../../utils/log.h"
+#include "../../utils/workers.h"
+
+#include <cmath>
+#include <cctype>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+using namespace mbz::math;
+using namespace mbz::math::bpcd;
+using namespace mbz::utils::logger;
+using namespace mbz::utils::heap;
+
+namespace {
+
+// walks the cells of a lattice with origin o and cell size size that the segment pierces
+// between distances start and end, in order. visit(l, r, c, exit) gets each cell and the
+// distance at which the segment leaves it, and returns false to stop the walk
+template<typename Visit>
+void march(const Vector3 &o, const Vector3 &size, const RaySeg &raySeg, float start, float end, int maxSteps, Visit visit) {
+  Vector3 p = raySeg.p + start * raySeg.d;
+  int cell[3], step[3];
+  float next[3], delta[3];
+  for (int i = 0; i < 3; i++) {
+    float d = raySeg.d.xyz[i];
+    cell[i] = int(floorf((p.xyz[i] - o.xyz[i]) / size.xyz[i]));
+    if (d >= mbz::math::tol) {
+      step[i] = 1;
+      next[i] = start + (o.xyz[i] + float(cell[i] + 1) * size.xyz[i] - p.xyz[i]) / d;
+      delta[i] = size.xyz[i] / d;
+    } else if (d <= -mbz::math::tol) {
+      step[i] = -1;
+      next[i] = start + (o.xyz[i] + float(cell[i]) * size.xyz[i] - p.xyz[i]) / d;
+      delta[i] = -size.xyz[i] / d;
+    } else {
+      step[i] = 0;
+      next[i] = delta[i] = INFINITY;
+    }
+  }
+
+  for (int i = 0; i < maxSteps; i++) {
+    float exit = std::min(end, std::min(next[0], std::min(next[1], next[2])));
+    if (!visit(cell[2], cell[1], cell[0], exit) || exit >= end)
+      return;
+    for (int j = 0; j < 3; j++) {
+      if (next[j] == exit) {
+        cell[j] += step[j];
+        next[j] += delta[j];
+      }
+    }
+  }
+}
+
+// walks the grid cells along the segment, descending into the sub-grids of refined cells.
+// visit(l, r, c, tris, count, exit) gets the base cell, the triangles to test (none for
+// empty cells) and the distance the segment leaves them at, and returns false to stop
+template<typename Visit>
+void walk(const Grid &grid, const RaySeg &raySeg, Visit visit) {
+  if (!grid.numCells)
+    return;  // nothing built
+  // only the part of the segment inside the grid's bounds can hit anything
+  Vector3 min = grid.bigBox.minExtent() - 0.5f * grid.cellSize;
+  Vector3 max = grid.bigBox.maxExtent() + 0.5f * grid.cellSize;
+  float start = 0.0f;
+  float end = raySeg.dist;
+  for (int i = 0; i < 3; i++) {
+    float d = raySeg.d.xyz[i];
+    if (fabsf(d) < mbz::math::tol) {
+      if (raySeg.p.xyz[i] < min.xyz[i] || raySeg.p.xyz[i] > max.xyz[i])
+        return;
+      continue;
+    }
+    float t0 = (min.xyz[i] - raySeg.p.xyz[i]) / d;
+    float t1 = (max.xyz[i] - raySeg.p.xyz[i]) / d;
+    start = std::max(start, std::min(t0, t1));
+    end = std::min(end, std::max(t0, t1));
+  }
+  if (start >= end)
+    return;
+
+  // a line crosses at most one cell per plane between cells, plus the ones it starts in
+  int maxSteps = grid.dims[0] + grid.dims[1] + grid.dims[2] + 6;
+  float enter = start;
+  march(grid.o, grid.cellSize, raySeg, start, end, maxSteps, [&](int l, int r, int c, float exit) {
+    const Grid::Cell *cell = grid.findCell(l, r, c);
+    bool more = true;
+    if (!cell) {
+      more = visit(l, r, c, nullptr, 0, exit);
+    } else if (cell->sub < 0) {
+      more = visit(l, r, c, grid.triIndices.data() + cell->begin, cell->count, exit);
+    } else {
+      const Grid::SubGrid &sub = grid.subGrids[cell->sub];
+      Vector3 origin = grid.o + Vector3(float(c) * grid.cellSize.x, float(r) * grid.cellSize.y, float(l) * grid.cellSize.z);
+      Vector3 size = (1.0f / float(sub.res)) * grid.cellSize;
+      march(origin, size, raySeg, enter, exit, 3 * sub.res + 3, [&](int sl, int sr, int sc, float subExit) {
+        // rounding can put the entry point a hair outside the cell
+        sl = std::clamp(sl, 0, sub.res - 1);
+        sr = std::clamp(sr, 0, sub.res - 1);
+        sc = std::clamp(sc, 0, sub.res - 1);
+        const Grid::Range &range = grid.subCells[sub.first + (sl * sub.res + sr) * sub.res + sc];
+        more = visit(l, r, c, grid.triIndices.data() + range.begin, range.count, subExit);
+        return more;
+      });
+    }
+    enter = exit;
+    return more;
+  });
+}
+
+}
+
+void Grid::getBoxes(std::vector<Aabb> &boxes) const {
+  boxes.clear();
+  for (const auto &cell : cells) {
+    if (cell.count)
+      boxes.push_back(cellBox(cell.l, cell.r, cell.c));
+  }
+}
+
+bool Grid::build(const TriangleView &trisPoints, std::optional<Vector3> cellSize, bool parallel) {
+  int n = int(trisPoints.size());
+  tris.size = 0;
+  if (!n) {
+    numCells = 0;  // traces nothing, whatever was built before
+    return false;
+  }
+  Vector3 min = trisPoints[0][0];
+  Vector3 max = trisPoints[0][0];
+  storage.triangles.resize(n);
+  for (int i = 0; i < n; i++) {
+    Bcs3 bcs;
+    bcs.init(trisPoints[i][0], trisPoints[i][1], trisPoints[i][2]);
+    tris.append(bcs);
+    storage.triangles[i].init(trisPoints[i][0], trisPoints[i][1], trisPoints[i][2], i);
+    for (int j = 0; j < 3; j++) {
+      min.x = std::min(min.x, trisPoints[i][j].x);
+      max.x = std::max(max.x, trisPoints[i][j].x);
+
+      min.y = std::min(min.y, trisPoints[i][j].y);
+      max.y = std::max(max.y, trisPoints[i][j].y);
+
+      min.z = std::min(min.z, trisPoints[i][j].z);
+      max.z = std::max(max.z, trisPoints[i][j].z);
+    }
+  }
+  bigBox.fromExtents(min, max);
+  o = bigBox.minExtent();
+  LOGINFO("Grid::build()", "Extents: {%.4f, %.4f, %.4f} / {%.4f, %.4f, %.4f}", min.x, min.y, min.z, max.x, max.y, max.z);
+  LOGINFO("Grid::build()", "Origin.: {%.4f, %.4f, %.4f}", o.x, o.y, o.z);
+  this->cellSize = cellSize.has_value() ? cellSize.value() : autoCellSize(min, max, n);
+  for (int i = 0; i < 3; i++)
+    dims[i] = std::max(1, int(ceilf((max.xyz[i] - min.xyz[i]) / this->cellSize.xyz[i])));
+  LOGINFO("Grid::build()", "Cells..: {%.4f, %.4f, %.4f} (%d x %d x %d)", this->cellSize.x, this->cellSize.y, this->cellSize.z, dims[0], dims[1], dims[2]);
+
+  // every (cell, triangle) pair sorted by cell, so each cell's triangles end up next to
+  // each other in triIndices. chunks of triangles are binned and sorted on their own, then
+  // merged in chunk order, which gives the same refs whether or not the build is parallel
+  int threads = parallel ? utils::multithread::Pool::shared()->size() : 1;
+  int chunkSize = std::max(minChunkSize, (n + 4 * threads - 1) / (4 * threads));
+  int numChunks = parallel ? (n + chunkSize - 1) / chunkSize : 1;
+  std::vector<std::vector<CellRef>> chunks(numChunks);
+  if (numChunks == 1) {
+    binTriangles(trisPoints, 0, n, chunks[0]);
+  } else {
+    struct BinTask : public utils::multithread::Task {
+      const Grid *grid;
+      const TriangleView *trisPoints;
+      int begin, end;
+      std::vector<CellRef> *refs;
+      virtual void perform(utils::multithread::Toolbox *toolbox) override {
+        grid->binTriangles(*trisPoints, begin, end, *refs);
+      }
+    };
+    utils::multithread::Workers workers(heap, numChunks);
+    for (int i = 0; i < numChunks; i++) {
+      auto task = std::make_unique<BinTask>();
+      task->grid = this;
+      task->trisPoints = &trisPoints;
+      task->begin = i * chunkSize;
+      task->end = std::min(n, task->begin + chunkSize);
+      task->refs = &chunks[i];
+      workers.todo.append_move(std::move(task));
+    }
+    workers.beginJoin();
+  }
+
+  std::vector<CellRef> refs;
+  std::vector<size_t> runs;
+  for (auto &chunk : chunks) {
+    runs.push_back(refs.size());
+    refs.insert(refs.end(), chunk.begin(), chunk.end());
+    std::vector<CellRef>().swap(chunk);
+  }
+  runs.push_back(refs.size());
+  for (size_t width = 1; width < chunks.size(); width *= 2) {
+    for (size_t i = 0; i + width < chunks.size(); i += 2 * width) {
+      size_t last = std::min(i + 2 * width, chunks.size());
+      std::inplace_merge(refs.begin() + runs[i], refs.begin() + runs[i + width], refs.begin() + runs[last]);
+    }
+  }
+
+  storage.triIndices.resize(refs.size());
+  numCells = 0;
+  for (size_t i = 0; i < refs.size(); i++) {
+    storage.triIndices[i] = refs[i][3];
+    if (!i || refs[i][0] != refs[i - 1][0] || refs[i][1] != refs[i - 1][1] || refs[i][2] != refs[i - 1][2])
+      numCells++;
+  }
+
+  // keep the table at most half full so probes stay short
+  uint32_t size = 16;
+  while (size < 2u * uint32_t(numCells))
+    size <<= 1;
+  storage.cells.assign(size, Cell { 0, 0, 0, 0, 0, -1 });
+  cellMask = size - 1;
+  for (size_t begin = 0; begin < refs.size();) {
+    size_t end = begin + 1;
+    while (end < refs.size() && refs[end][0] == refs[begin][0] && refs[end][1] == refs[begin][1] && refs[end][2] == refs[begin][2])
+      end++;
+    uint32_t i = getHashOf(refs[begin][0], refs[begin][1], refs[begin][2]) & cellMask;
+    while (storage.cells[i].count)
+      i = (i + 1) & cellMask;
+    storage.cells[i] = Cell { refs[begin][0], refs[begin][1], refs[begin][2], int(begin), int(end - begin), -1 };
+    begin = end;
+  }
+
+  refine(trisPoints);
+  mapping = nullptr;
+  view();
+  logStats();
+  return true;
+}
+
+Vector3 Grid::autoCellSize(const Vector3 &min, const Vector3 &max, int numTris) {
+  Vector3 extent = max - min;
+  float longest = std::max(extent.x, std::max(extent.y, extent.z));
+  if (longest <= 0.0f || numTris <= 0)
+    return Vector3(1.0f, 1.0f, 1.0f);
+  // flat scenes would otherwise have no volume to spread the cells over
+  float volume = 1.0f;
+  for (int i = 0; i < 3; i++)
+    volume *= std::max(extent.xyz[i], 0.01f * longest);
+  float size = cbrtf(volume / (cellsPerTri * float(numTris)));
+  // stay within reach of the traversal's step budget on very large scenes
+  size = std::max(size, longest / 1024.0f);
+  return Vector3(size, size, size);
+}
+
+void Grid::refine(const TriangleView &trisPoints) {
+  storage.subGrids.clear();
+  storage.subCells.clear();
+  std::vector<std::vector<int>> lists;
+  for (auto &cell : storage.cells) {
+    if (cell.count <= maxCellTris)
+      continue;
+    SubGrid sub;
+    sub.res = std::clamp(int(ceilf(cbrtf(float(cell.count) / float(maxCellTris / 4)))), 2, maxSubRes);
+    sub.first = int(storage.subCells.size());
+    cell.sub = int(storage.subGrids.size());
+    storage.subGrids.push_back(sub);
+
+    Aabb box = cellBox(cell.l, cell.r, cell.c);
+    Vector3 size = (1.0f / float(sub.res)) * cellSize;
+    Vector3 origin = box.minExtent();
+    lists.assign(sub.res * sub.res * sub.res, std::vector<int>());
+    for (int i = 0; i < cell.count; i++) {
+      int index = storage.triIndices[cell.begin + i];
+      const auto &triPoints = trisPoints[index];
+      Vector3 triMin = triPoints[0], triMax = triPoints[0];
+      for (int j = 1; j < 3; j++) {
+        for (int k = 0; k < 3; k++) {
+          triMin.xyz[k] = std::min(triMin.xyz[k], triPoints[j].xyz[k]);
+          triMax.xyz[k] = std::max(triMax.xyz[k], triPoints[j].xyz[k]);
+        }
+      }
+      int lo[3], hi[3];
+      for (int k = 0; k < 3; k++) {
+        lo[k] = std::clamp(int(floorf((triMin.xyz[k] - origin.xyz[k]) / size.xyz[k])) - 1, 0, sub.res - 1);
+        hi[k] = std::clamp(int(floorf((triMax.xyz[k] - origin.xyz[k]) / size.xyz[k])) + 1, 0, sub.res - 1);
+      }
+      // conservative: the sub-cell must overlap the triangle's bounds and straddle its plane
+      Vector3 n = triPoints[0].point(triPoints[1]).cross(triPoints[0].point(triPoints[2]));
+      for (int l = lo[2]; l <= hi[2]; l++) {
+        for (int r = lo[1]; r <= hi[1]; r++) {
+          for (int c = lo[0]; c <= hi[0]; c++) {
+            Vector3 half = 0.5f * size;
+            Vector3 center = origin + Vector3((float(c) + 0.5f) * size.x, (float(r) + 0.5f) * size.y, (float(l) + 0.5f) * size.z);
+            Vector3 pad = 1.01f * half;
+            bool overlaps = true;
+            for (int k = 0; k < 3; k++)
+              overlaps = overlaps && triMin.xyz[k] <= center.xyz[k] + pad.xyz[k] && triMax.xyz[k] >= center.xyz[k] - pad.xyz[k];
+            if (!overlaps)
+              continue;
+            float radius = fabsf(n.x) * pad.x + fabsf(n.y) * pad.y + fabsf(n.z) * pad.z;
+            if (fabsf(n.dot(center - triPoints[0])) > radius)
+              continue;
+            lists[(l * sub.res + r) * sub.res + c].push_back(index);
+          }
+        }
+      }
+    }
+    for (auto &list : lists) {
+      storage.subCells.push_back(Range { int(storage.triIndices.size()), int(list.size()) });
+      storage.triIndices.insert(storage.triIndices.end(), list.begin(), list.end());
+    }
+  }
+}
+
+void Grid::logStats() const {
+  int maxTris = 0;
+  size_t refs = 0;
+  for (const auto &cell : cells) {
+    if (!cell.count)
+      continue;
+    refs += cell.count;
+    maxTris = std::max(maxTris, cell.count);
+  }
+  int maxSubTris = 0;
+  size_t subRefs = 0;
+  for (const auto &range : subCells) {
+    subRefs += range.count;
+    maxSubTris = std::max(maxSubTris, range.count);
+  }
+  float kbs = float(cells.size() * sizeof(Cell) + triIndices.size() * sizeof(int) + subGrids.size() * sizeof(SubGrid) + subCells.size() * sizeof(Range)) / 1024.0f;
+  LOGINFO("Grid::build()", "%d cells, %.2f avg / %d max triangles per cell", numCells, numCells ? float(refs) / float(numCells) : 0.0f, maxTris);
+  LOGINFO("Grid::build()", "%zu refined cells, %zu sub-cells, %.2f avg / %d max triangles per sub-cell", subGrids.size(), subCells.size(),
+          subCells.empty() ? 0.0f : float(subRefs) / float(subCells.size()), maxSubTris);
+  LOGINFO("Grid::build()", "%.2f kbs", kbs);
+}
+
+void Grid::view() {
+  triangles = storage.triangles;
+  cells = storage.cells;
+  triIndices = storage.triIndices;
+  subGrids = storage.subGrids;
+  subCells = storage.subCells;
+}
+
+namespace {
+
+struct CacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  // layout of the records, so a build with another compiler or struct change is refused
+  uint32_t sizes[5];
+  float o[3];
+  float cellSize[3];
+  float min[3];
+  float max[3];
+  int dims[3];
+  int numCells;
+  uint32_t cellMask;
+  // sections in the order triangles, cells, triIndices, subGrids, subCells
+  uint64_t offsets[5];
+  uint64_t counts[5];
+};
+
+constexpr char cacheMagic[4] = { 'B', 'P', 'C', 'G' };
+
+// removes the files beside path saved under the same stem with another key, <stem>.<key
+// as 16 hex digits>.grid, which the file at path supersedes. files of other stems, and
+// names of any other shape, are left alone
+void removeSuperseded(const std::string &path) {
+  namespace fs = std::filesystem;
+  const std::string extension = ".grid";
+  const size_t keyLength = 16;
+  fs::path file(path);
+  std::string name = file.filename().string();
+  if (name.size() <= keyLength + extension.size() || name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+    return;
+  size_t keyStart = name.size() - extension.size() - keyLength;
+  if (name[keyStart - 1] != '.')
+    return;
+  auto isKey = [&](const std::string &other) {
+    for (size_t i = keyStart; i < keyStart + keyLength; i++)
+      if (!isxdigit((unsigned char) other[i]))
+        return false;
+    return true;
+  };
+  std::error_code error;
+  std::vector<fs::path> superseded;
+  fs::path dir = file.has_parent_path() ? file.parent_path() : fs::path(".");
+  for (fs::directory_iterator it(dir, error), end; !error && it != end; it.increment(error)) {
+    std::string other = it->path().filename().string();
+    if (other != name && other.size() == name.size() && other.compare(0, keyStart, name, 0, keyStart) == 0
+        && other.compare(keyStart + keyLength, extension.size(), extension) == 0 && isKey(other))
+      superseded.push_back(it->path());
+  }
+  for (const auto &old : superseded) {
+    // a bake still mapping it keeps the old inode on posix, elsewhere the file stays
+    if (fs::remove(old, error))
+      LOGINFO("Grid::save()", "removed superseded '%s'", old.string().c_str());
+  }
+}
+
+// every index the traversal follows stays inside its section, and the cell table has the
+// empty slot its probes stop at
+bool validCache(const CacheHeader &header, Span<const Triangle> triangles, Span<const Grid::Cell> cells, Span<const int> triIndices,
+                Span<const Grid::SubGrid> subGrids, Span<const Grid::Range> subCells) {
+  uint64_t tableSize = uint64_t(header.cellMask) + 1;
+  if (tableSize != cells.size() || (tableSize & (tableSize - 1)) || header.numCells < 0 || uint64_t(header.numCells) >= tableSize)
+    return false;
+  for (int i = 0; i < 3; i++) {
+    if (!(header.cellSize[i] > 0.0f) || !std::isfinite(header.cellSize[i]) || header.dims[i] < 1)
+      return false;
+  }
+  auto inTriIndices = [&](int begin, int count) {
+    return begin >= 0 && count >= 0 && uint64_t(begin) + uint64_t(count) <= triIndices.size();
+  };
+  int occupied = 0;
+  for (const auto &cell : cells) {
+    if (!inTriIndices(cell.begin, cell.count) || cell.sub < -1 || (cell.sub >= 0 && uint64_t(cell.sub) >= subGrids.size()))
+      return false;
+    occupied += cell.count ? 1 : 0;
+  }
+  if (uint64_t(occupied) >= tableSize)
+    return false;
+  for (int index : triIndices) {
+    if (index < 0 || uint64_t(index) >= triangles.size())
+      return false;
+  }
+  for (const auto &sub : subGrids) {
+    uint64_t subCount = uint64_t(sub.res) * uint64_t(sub.res) * uint64_t(sub.res);
+    if (sub.res < 1 || sub.res > Grid::maxSubRes || sub.first < 0 || uint64_t(sub.first) + subCount > subCells.size())
+      return false;
+  }
+  for (const auto &range : subCells) {
+    if (!inTriIndices(range.begin, range.count))
+      return false;
+  }
+  return true;
+}
+constexpr uint64_t cacheAlignment = 64;
+
+uint64_t alignUp(uint64_t offset) {
+  return (offset + cacheAlignment - 1) & ~(cacheAlignment - 1);
+}
+
+}
+
+uint64_t Grid::cacheKey(const TriangleView &trisPoints, std::optional<Vector3> cellSize) {
+  uint64_t hash = hasher64();
+  uint32_t version = cacheVersion;
+  hash = hasher64(hash, &version, sizeof(version));
+  for (size_t i = 0; i < trisPoints.size(); i++) {
+    for (const auto &p : trisPoints[i])
+      hash = hasher64(hash, p.xyz, sizeof(p.xyz));
+  }
+  if (cellSize.has_value())
+    hash = hasher64(hash, cellSize->xyz, sizeof(cellSize->xyz));
+  return hash;
+}
+
+bool Grid::save(std::string_view fileName, uint64_t key) const {
+  CacheHeader header = { };
+  std::copy(cacheMagic, cacheMagic + 4, header.magic);
+  header.version = cacheVersion;
+  header.key = key;
+  header.sizes[0] = sizeof(Triangle);
+  header.sizes[1] = sizeof(Cell);
+  header.sizes[2] = sizeof(int);
+  header.sizes[3] = sizeof(SubGrid);
+  header.sizes[4] = sizeof(Range);
+  Vector3 min = bigBox.minExtent();
+  Vector3 max = bigBox.maxExtent();
+  for (int i = 0; i < 3; i++) {
+    header.o[i] = o.xyz[i];
+    header.cellSize[i] = cellSize.xyz[i];
+    header.min[i] = min.xyz[i];
+    header.max[i] = max.xyz[i];
+    header.dims[i] = dims[i];
+  }
+  header.numCells = numCells;
+  header.cellMask = cellMask;
+
+  const void *sections[5] = { triangles.data(), cells.data(), triIndices.data(), subGrids.data(), subCells.data() };
+  size_t counts[5] = { triangles.size(), cells.size(), triIndices.size(), subGrids.size(), subCells.size() };
+  uint64_t offset = alignUp(sizeof(CacheHeader));
+  for (int i = 0; i < 5; i++) {
+    header.offsets[i] = offset;
+    header.counts[i] = counts[i];
+    offset = alignUp(offset + counts[i] * header.sizes[i]);
+  }
+
+  // unique per thread and moment, so concurrent bakes sharing assets/ never write one file
+  std::string path(fileName);
+  uint64_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%016llx.tmp", (unsigned long long) unique);
+  std::string temp = path + suffix;
+  FILE *fp = fopen(temp.c_str(), "wb");
+  if (!fp) {
+    LOGINFO("Grid::save()", "unable to write '%s'", temp.c_str());
+    return false;
+  }
+  const uint8_t zeros[cacheAlignment] = { };
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+  uint64_t written = sizeof(header);
+  for (int i = 0; ok && i < 5; i++) {
+    ok = fwrite(zeros, 1, header.offsets[i] - written, fp) == header.offsets[i] - written;
+    size_t bytes = counts[i] * header.sizes[i];
+    if (ok && bytes)
+      ok = fwrite(sections[i], bytes, 1, fp) == 1;
+    written = header.offsets[i] + bytes;
+  }
+  ok = fclose(fp) == 0 && ok;
+  std::error_code error;
+  if (ok)
+    std::filesystem::rename(temp, path, error);
+  if (!ok || error) {
+    LOGINFO("Grid::save()", "unable to write '%s'", path.c_str());
+    std::filesystem::remove(temp, error);
+    return false;
+  }
+  LOGINFO("Grid::save()", "'%s' (%.2f kbs)", std::string(fileName).c_str(), float(written) / 1024.0f);
+  removeSuperseded(path);
+  return ok;
+}
+
+bool Grid::load(std::string_view fileName, uint64_t key) {
+  auto file = std::make_shared<utils::MappedFile>(fileName);
+  if (!file->valid() || file->size < sizeof(CacheHeader))
+    return false;
+  const CacheHeader &header = *reinterpret_cast<const CacheHeader*>(file->data);
+  uint32_t sizes[5] = { sizeof(Triangle), sizeof(Cell), sizeof(int), sizeof(SubGrid), sizeof(Range) };
+  if (!std::equal(cacheMagic, cacheMagic + 4, header.magic) || header.version != cacheVersion || header.key != key
+      || !std::equal(sizes, sizes + 5, header.sizes)) {
+    LOGINFO("Grid::load()", "'%s' is stale", std::string(fileName).c_str());
+    return false;
+  }
+  for (int i = 0; i < 5; i++) {
+    if (header.offsets[i] % cacheAlignment || header.offsets[i] > file->size || header.counts[i] > (file->size - header.offsets[i]) / sizes[i])
+      return false;
+  }
+
+  auto section = [&](int i) {
+    return file->data + header.offsets[i];
+  };
+  Span<const Triangle> fileTriangles(reinterpret_cast<const Triangle*>(section(0)), header.counts[0]);
+  Span<const Cell> fileCells(reinterpret_cast<const Cell*>(section(1)), header.counts[1]);
+  Span<const int> fileTriIndices(reinterpret_cast<const int*>(section(2)), header.counts[2]);
+  Span<const SubGrid> fileSubGrids(reinterpret_cast<const SubGrid*>(section(3)), header.counts[3]);
+  Span<const Range> fileSubCells(reinterpret_cast<const Range*>(section(4)), header.counts[4]);
+  // a matching key doesn't make the contents sound, a truncated or edited file must not
+  // send a trace outside the mapping
+  if (!validCache(header, fileTriangles, fileCells, fileTriIndices, fileSubGrids, fileSubCells)) {
+    LOGWARN("Grid::load()", "'%s' is corrupt", std::string(fileName).c_str());
+    return false;
+  }
+  triangles = fileTriangles;
+  cells = fileCells;
+  triIndices = fileTriIndices;
+  subGrids = fileSubGrids;
+  subCells = fileSubCells;
+  storage = Storage();
+  mapping = file;
+
+  Vector3 min, max;
+  for (int i = 0; i < 3; i++) {
+    o.xyz[i] = header.o[i];
+    cellSize.xyz[i] = header.cellSize[i];
+    min.xyz[i] = header.min[i];
+    max.xyz[i] = header.max[i];
+    dims[i] = header.dims[i];
+  }
+  bigBox.fromExtents(min, max);
+  numCells = header.numCells;
+  cellMask = header.cellMask;
+
+  // the viewer's barycentric queries still want Bcs3s
+  tris.size = 0;
+  for (const auto &triangle : triangles) {
+    Bcs3 bcs;
+    bcs.init(triangle.v0, triangle.v1, triangle.v2);
+    tris.append(bcs);
+  }
+  LOGINFO("Grid::load()", "'%s' mapped, %zu triangles, %d cells", std::string(fileName).c_str(), triangles.size(), numCells);
+  return true;
+}
+
+void Grid::binTriangles(const TriangleView &trisPoints, int begin, int end, std::vector<CellRef> &refs) const {
+  for (int index = begin; index < end; index++) {
+    const auto &triPoints = trisPoints[index];
+    int l1, l2, l3, lRange[2];
+    int r1, r2, r3, rRange[2];
+    int c1, c2, c3, cRange[2];
+    getCellForPoint(triPoints[0], l1, r1, c1);
+    getCellForPoint(triPoints[1], l2, r2, c2);
+    getCellForPoint(triPoints[2], l3, r3, c3);
+    lRange[0] = std::min(l1, std::min(l2, l3)) - 1;
+    rRange[0] = std::min(r1, std::min(r2, r3)) - 1;
+    cRange[0] = std::min(c1, std::min(c2, c3)) - 1;
+    lRange[1] = std::max(l1, std::max(l2, l3)) + 1;
+    rRange[1] = std::max(r1, std::max(r2, r3)) + 1;
+    cRange[1] = std::max(c1, std::max(c2, c3)) + 1;
+
+    //printf("levels.: %d - %d\n", lRange[0], lRange[1]);
+    //printf("rows...: %d - %d\n", rRange[0], rRange[1]);
+    //printf("columns: %d - %d\n", cRange[0], cRange[1]);
+
+    Sphere sphere2(triPoints);
+    for (int l = lRange[0]; l <= lRange[1]; l++) {
+      for (int r = rRange[0]; r <= rRange[1]; r++) {
+        for (int c = cRange[0]; c <= cRange[1]; c++) {
+          Aabb aabb = cellBox(l, r, c);
+          Sphere sphere(aabb.p, aabb.halfSize.lengthSq());
+          if (!sphere.touches(sphere2))
+            continue;
+          if(!aabb.intersects(triPoints))
+            continue;
+
+          //if (!aabb.collidesWith(triPoints))
+          //  continue;
+          refs.push_back( { l, r, c, index });
+        }
+      }
+    }
+  }
+  std::sort(refs.begin(), refs.end());
+}
+
+bool Grid::traceRay(RaySeg raySeg, Trace &trace, std::optional<std::reference_wrapper<std::vector<std::array<int, 3>>>> indices) const {
+
+  trace.raySeg = raySeg;
+  trace.bcsCoord = std::nullopt;
+  trace.point = std::nullopt;
+  if (indices.has_value())
+    indices->get().clear();
+
+  WatertightRay ray(raySeg);
+  walk(*this, raySeg, [&](int l, int r, int c, const int *cellTris, int count, float exit) {
+    if (indices.has_value() && (indices->get().empty() || indices->get().back() != std::array<int, 3> { l, r, c }))
+      indices->get().push_back( { l, r, c });
+    bool hit = false;
+    ray.dist = exit;
+    for (int i = 0; i < count; i++) {
+      int j = cellTris[i];
+      float t;
+      BcsCoord coord;
+      if (triangles[j].intersect(ray, t, coord)) {
+        trace.index = j;
+        trace.bcsCoord = coord;
+        trace.point = raySeg.p + t * raySeg.d;
+        ray.dist = t;
+        hit = true;
+      }
+    }
+    if (hit)
+      trace.raySeg.dist = ray.dist;
+    return !hit;
+  });
+
+  return trace();
+  /*
+  bool hit = false;
+  for (int i = 0; i < tris.size; i++) {
+    auto bcs = tris.kp()[i];
+    auto coord = bcs.project(raySeg);
+    if (coord.has_value()) {
+      trace.index = i;
+      trace.bcsCoord = coord;
+      trace.point = bcs.o + coord->x * bcs.u + coord->y * bcs.v;
+      raySeg.dist = raySeg.p.point(*trace.point).dot(raySeg.d);
+      hit = true;
+    }
+  }
+  return hit;
+  */
+}
+
+bool Grid::occluded(const RaySeg &raySeg) const {
+  bool hit = false;
+  WatertightRay ray(raySeg);
+  walk(*this, raySeg, [&](int l, int r, int c, const int *cellTris, int count, float exit) {
+    ray.dist = exit;
+    for (int i = 0; i < count; i++) {
+      if (triangles[cellTris[i]].hits(ray)) {
+        hit = true;
+        return false;
+      }
+    }
+    return true;
+  });
+  return hit;
+}
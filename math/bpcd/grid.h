@@ -1,116 +1,160 @@
-#pragma once
-
-#include "../bcs.h"
-#include "../../utils/hash.h"
-#include <array>
-#include <vector>
-#include <algorithm>
-#include <tuple>
-#include "../../utils/array.h"
-
-using namespace mbz::math;
-using namespace mbz::utils;
-using namespace mbz::utils::heap;
-
-namespace mbz {
-namespace math {
-namespace bpcd {
-
-struct Grid {
-  static uint32_t getHashOf(int l, int r, int c);
-
-  struct Cell : public utils::heap::Hashable {
-    int l, r, c;
-    Aabb aabb;
-    Array<int> triIndices;
-
-    Cell& operator =(const Cell &rhs) {
-      l = rhs.l;
-      r = rhs.r;
-      c = rhs.c;
-      aabb = rhs.aabb;
-      triIndices.release();
-      triIndices.init(rhs.triIndices.heap, 8, rhs.triIndices.growth);
-      for (int i = 0; i < rhs.triIndices.size; i++)
-        triIndices.append(rhs.triIndices.kp()[i]);
-      return *this;
-    }
-
-    virtual uint32_t getHashOf() const override {
-      return Grid::getHashOf(l, r, c);
-    }
-
-    Cell(int l_, int r_, int c_, Aabb aabb_, std::shared_ptr<Heap> heap)
-        :
-        l(l_),
-        r(r_),
-        c(c_),
-        aabb(aabb_),
-        triIndices(heap, 8) {
-    }
-
-  };
-
-  struct Trace {
-    RaySeg raySeg;
-    int index;
-    std::optional<BcsCoord> bcsCoord;
-    std::optional<Vector3> point;
-    Trace(const RaySeg& raySeg)
-        :
-        raySeg(raySeg),
-        index(-1),
-        bcsCoord(std::nullopt),
-        point(std::nullopt) {
-    }
-    Trace(Ray ray, float dist)
-        :
-        raySeg(ray, dist),
-        index(-1),
-        bcsCoord(std::nullopt),
-        point(std::nullopt) {
-    }
-    bool operator()() const {
-      return bcsCoord.has_value() && bcsCoord.value().inside();
-    }
-  };
-
-  std::shared_ptr<Heap> heap;
-  Array<Bcs3> tris;
-  Hashmap<Cell> cells;
-
-  Vector3 o;
-  Vector3 cellSize;
-  Aabb bigBox;
-
-  Aabb cellBox(int l, int r, int c) const {
-    Vector3 p = o;
-    p.x = o.x + (float(c) + 0.5f) * cellSize.x;
-    p.y = o.y + (float(r) + 0.5f) * cellSize.y;
-    p.z = o.z + (float(l) + 0.5f) * cellSize.z;
-    return Aabb(p, 0.5f * cellSize);
-  }
-
-
-  void getCellForPoint(Vector3 p, int &l, int &r, int &c) const {
-    p -= o;
-    l = int(floorf(p.z / cellSize.z));
-    r = int(floorf(p.y / cellSize.y));
-    c = int(floorf(p.x / cellSize.x));
-  }
-
-  Grid(std::shared_ptr<Heap> heap)
-      :
-      heap(heap),
-      tris(heap, 1024),
-      cells(1024, heap) {
-  }
-  bool build(const std::vector<std::array<Vector3, 3>> &trisPoints, Vector3 cellSize);
-  void getBoxes(std::vector<Aabb> &boxes);
-
-  bool traceRay(RaySeg raySeg, Trace &trace, std::optional<std::reference_wrapper<std::vector<std::array<int, 3>>>> indices = std::nullopt) const;
-};
-
-}
-}
-}
+#pragma once
+
+#include "../bcs.h"
+#include "tracer.h"
+#include "triangle.h"
+#include "../../utils/hash.h"
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include "../../utils/array.h"
+#include "../../utils/span.h"
+#include "../../utils/file.h"
+
+using namespace mbz::math;
+using namespace mbz::utils;
+using namespace mbz::utils::heap;
+
+namespace mbz {
+namespace math {
+namespace bpcd {
+
+struct Grid : public Tracer {
+  static constexpr int minChunkSize = 4096;  // triangles binned by one build task at least
+  static constexpr float cellsPerTri = 4.0f;  // base resolution target when none is given
+  static constexpr int maxCellTris = 16;  // cells holding more triangles get a sub-grid
+  static constexpr int maxSubRes = 8;
+
+  static uint32_t getHashOf(int l, int r, int c) {
+    uint32_t hash = uint32_t(l) * 73856093u ^ uint32_t(r) * 19349663u ^ uint32_t(c) * 83492791u;
+    return hash * 0x9e3779b1u;
+  }
+
+  // a slot of the cell table. the cell's triangles are triIndices[begin, begin + count),
+  // empty slots have no triangles
+  struct Cell {
+    int l, r, c;
+    int begin;
+    int count;
+    int sub;  // index into subGrids, -1 when the cell is not refined
+  };
+
+  // dense cells are split again into res^3 sub-cells, stored in subCells from first
+  // with x varying fastest. their triangles live in triIndices after the base cells
+  struct Range {
+    int begin;
+    int count;
+  };
+  struct SubGrid {
+    int res;
+    int first;
+  };
+
+  using Trace = bpcd::Trace;
+
+  std::shared_ptr<Heap> heap;
+  Array<Bcs3> tris;
+
+  // the built index, read only. these point into the storage below after build() and
+  // straight into the mapped file after load()
+  Span<const Triangle> triangles;  // intersection records, same order as tris
+  Span<const Cell> cells;  // open addressed with linear probing
+  Span<const int> triIndices;  // triangles of every cell, one cell after another
+  Span<const SubGrid> subGrids;
+  Span<const Range> subCells;
+  uint32_t cellMask = 0;
+  int numCells = 0;
+
+  int dims[3] = { 0, 0, 0 };  // base cells across bigBox
+
+  Vector3 o;
+  Vector3 cellSize;
+  Aabb bigBox;
+
+  Aabb cellBox(int l, int r, int c) const {
+    Vector3 p = o;
+    p.x = o.x + (float(c) + 0.5f) * cellSize.x;
+    p.y = o.y + (float(r) + 0.5f) * cellSize.y;
+    p.z = o.z + (float(l) + 0.5f) * cellSize.z;
+    return Aabb(p, 0.5f * cellSize);
+  }
+
+
+  void getCellForPoint(Vector3 p, int &l, int &r, int &c) const {
+    p -= o;
+    l = int(floorf(p.z / cellSize.z));
+    r = int(floorf(p.y / cellSize.y));
+    c = int(floorf(p.x / cellSize.x));
+  }
+
+  const Cell* findCell(int l, int r, int c) const {
+    if (cells.empty())
+      return nullptr;
+    uint32_t i = getHashOf(l, r, c) & cellMask;
+    while (true) {
+      const Cell &cell = cells[i];
+      if (!cell.count)
+        return nullptr;
+      if (cell.l == l && cell.r == r && cell.c == c)
+        return &cell;
+      i = (i + 1) & cellMask;
+    }
+  }
+
+  Grid(std::shared_ptr<Heap> heap)
+      :
+      heap(heap),
+      tris(heap, 1024) {
+  }
+  // picks cubic cells so the base grid has about cellsPerTri cells per triangle
+  static Vector3 autoCellSize(const Vector3 &min, const Vector3 &max, int numTris);
+
+  // without a cell size the base resolution comes from autoCellSize
+  bool build(const TriangleView &trisPoints, std::optional<Vector3> cellSize = std::nullopt, bool parallel = true);
+
+  // cache files hold the built index as-is, so load() only maps the file and points the
+  // views at it. key is the content hash of the source triangles and build settings
+  static constexpr uint32_t cacheVersion = 1;
+  static uint64_t cacheKey(const TriangleView &trisPoints, std::optional<Vector3> cellSize);
+  // written to a temporary beside fileName and renamed over it, so grids still mapping an
+  // older copy keep its inode and no reader ever maps a half written file. a fileName of
+  // the form <stem>.<key as 16 hex digits>.grid also removes the other keys of that stem
+  // (see createTracer)
+  bool save(std::string_view fileName, uint64_t key) const;
+  // fails on a missing file, another version or another key
+  bool load(std::string_view fileName, uint64_t key);
+  void getBoxes(std::vector<Aabb> &boxes) const;
+
+  bool traceRay(RaySeg raySeg, Trace &trace, std::optional<std::reference_wrapper<std::vector<std::array<int, 3>>>> indices) const;
+
+  virtual bool traceRay(RaySeg raySeg, Trace &trace) const override {
+    return traceRay(raySeg, trace, std::nullopt);
+  }
+  virtual bool occluded(const RaySeg &raySeg) const override;
+
+  virtual Aabb bounds() const override {
+    return bigBox;
+  }
+
+ protected:
+  struct Storage {
+    std::vector<Triangle> triangles;
+    std::vector<Cell> cells;
+    std::vector<int> triIndices;
+    std::vector<SubGrid> subGrids;
+    std::vector<Range> subCells;
+  } storage;
+  std::shared_ptr<utils::MappedFile> mapping;
+  void view();
+
+  using CellRef = std::array<int, 4>;  // l, r, c, triangle
+  // appends the cells touched by triangles [begin, end) to refs and sorts them
+  void binTriangles(const TriangleView &trisPoints, int begin, int end, std::vector<CellRef> &refs) const;
+  void refine(const TriangleView &trisPoints);
+  void logStats() const;
+};
+
+}
+}
+}
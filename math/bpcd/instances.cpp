@@ -0,0 +1,257 @@
+#include "instances.h"
+#include "../../utils/log.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace mbz {
+namespace math {
+namespace bpcd {
+
+namespace {
+
+bool hitsBox(const float *min, const float *max, const Vector3 &o, const Vector3 &inv, float dist) {
+  float t0 = 0.0f;
+  float t1 = dist;
+  for (int i = 0; i < 3; i++) {
+    float tNear = (min[i] - o.xyz[i]) * inv.xyz[i];
+    float tFar = (max[i] - o.xyz[i]) * inv.xyz[i];
+    if (tNear > tFar)
+      std::swap(tNear, tFar);
+    t0 = std::max(t0, tNear);
+    t1 = std::min(t1, tFar);
+    if (t0 > t1)
+      return false;
+  }
+  return true;
+}
+
+Vector3 inverse(const Vector3 &d) {
+  Vector3 inv;
+  for (int i = 0; i < 3; i++)
+    inv.xyz[i] = fabsf(d.xyz[i]) > math::tol ? 1.0f / d.xyz[i] : (d.xyz[i] < 0.0f ? -1e30f : 1e30f);
+  return inv;
+}
+
+}
+
+InstanceBvh::InstanceBvh(std::vector<Instance> instances) {
+  for (auto &instance : instances) {
+    if (!instance.blas)
+      continue;
+    Placed p;
+    p.instance = instance;
+    p.mirrored = instance.linear.determinant() < 0.0f;
+    if (p.mirrored && !instance.mirroredBlas) {
+      LOGERROR("InstanceBvh::InstanceBvh()", "mirrored instance without a flipped blas, its back faces will be hit");
+      p.mirrored = false;
+    }
+    p.tracer = p.mirrored ? instance.mirroredBlas.get() : instance.blas.get();
+    p.toObject = instance.linear.inverted();
+    // world box around the eight corners of the object box
+    Aabb box = instance.blas->bounds();
+    Vector3 lo = box.minExtent(), hi = box.maxExtent();
+    for (int i = 0; i < 3; i++) {
+      p.min[i] = 1e30f;
+      p.max[i] = -1e30f;
+    }
+    for (int c = 0; c < 8; c++) {
+      Vector3 corner((c & 1) ? hi.x : lo.x, (c & 2) ? hi.y : lo.y, (c & 4) ? hi.z : lo.z);
+      Vector3 w = instance.linear * corner + instance.translation;
+      for (int i = 0; i < 3; i++) {
+        p.min[i] = std::min(p.min[i], w.xyz[i]);
+        p.max[i] = std::max(p.max[i], w.xyz[i]);
+      }
+    }
+    placed.push_back(p);
+  }
+  if (placed.empty())
+    return;
+  nodes.reserve(placed.size() * 2);
+  buildNode(0, int(placed.size()));
+  const Node &root = nodes[0];
+  bigBox.fromExtents(Vector3(root.min[0], root.min[1], root.min[2]), Vector3(root.max[0], root.max[1], root.max[2]));
+  LOGINFO("InstanceBvh::InstanceBvh()", "%zu instances, %zu nodes", placed.size(), nodes.size());
+}
+
+int InstanceBvh::buildNode(int begin, int end) {
+  int index = int(nodes.size());
+  nodes.emplace_back();
+  Node node;
+  float cmin[3], cmax[3];
+  for (int i = 0; i < 3; i++) {
+    node.min[i] = cmin[i] = 1e30f;
+    node.max[i] = cmax[i] = -1e30f;
+  }
+  for (int j = begin; j < end; j++) {
+    for (int i = 0; i < 3; i++) {
+      float c = 0.5f * (placed[j].min[i] + placed[j].max[i]);
+      node.min[i] = std::min(node.min[i], placed[j].min[i]);
+      node.max[i] = std::max(node.max[i], placed[j].max[i]);
+      cmin[i] = std::min(cmin[i], c);
+      cmax[i] = std::max(cmax[i], c);
+    }
+  }
+  if (end - begin <= maxLeafSize) {
+    node.offset = begin;
+    node.count = end - begin;
+    nodes[index] = node;
+    return index;
+  }
+  // median split on the widest spread of centers, plenty for a few thousand instances
+  int axis = 0;
+  for (int i = 1; i < 3; i++)
+    if (cmax[i] - cmin[i] > cmax[axis] - cmin[axis])
+      axis = i;
+  int mid = (begin + end) / 2;
+  std::nth_element(placed.begin() + begin, placed.begin() + mid, placed.begin() + end, [axis](const Placed &a, const Placed &b) {
+    return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis];
+  });
+  node.count = 0;
+  buildNode(begin, mid);
+  node.offset = buildNode(mid, end);
+  nodes[index] = node;
+  return index;
+}
+
+RaySeg InstanceBvh::toObject(const Placed &placed, const RaySeg &raySeg, float &scale) const {
+  Vector3 d = placed.toObject * raySeg.d;
+  scale = d.length();
+  RaySeg seg(Ray(), raySeg.dist * scale);
+  seg.p = placed.toObject * (raySeg.p - placed.instance.translation);
+  seg.d = scale > 0.0f ? (1.0f / scale) * d : d;
+  return seg;
+}
+
+bool InstanceBvh::traceRay(RaySeg raySeg, Trace &trace) const {
+  trace.raySeg = raySeg;
+  trace.bcsCoord = std::nullopt;
+  trace.point = std::nullopt;
+  if (nodes.empty() || raySeg.dist <= 0.0f)
+    return false;
+
+  Vector3 inv = inverse(raySeg.d);
+  RaySeg seg = raySeg;
+  bool hit = false;
+  int stack[64];
+  int top = 0;
+  int current = 0;
+  while (true) {
+    const Node &node = nodes[current];
+    if (hitsBox(node.min, node.max, seg.p, inv, seg.dist)) {
+      if (!node.leaf()) {
+        stack[top++] = node.offset;
+        current = current + 1;
+        continue;
+      }
+      for (int i = node.offset; i < node.offset + node.count; i++) {
+        float scale;
+        RaySeg objectSeg = toObject(placed[i], seg, scale);
+        Trace objectTrace(objectSeg);
+        if (scale <= 0.0f || !placed[i].tracer->traceRay(objectSeg, objectTrace))
+          continue;
+        float dist = objectTrace.raySeg.dist / scale;
+        if (dist > seg.dist)
+          continue;
+        trace.index = objectTrace.index + placed[i].instance.firstIndex;
+        trace.bcsCoord = objectTrace.bcsCoord;
+        if (trace.bcsCoord && placed[i].mirrored)
+          std::swap(trace.bcsCoord->x, trace.bcsCoord->y);
+        trace.point = seg.p + dist * seg.d;
+        seg.dist = dist;
+        hit = true;
+      }
+    }
+    if (!top)
+      break;
+    current = stack[--top];
+  }
+  if (hit)
+    trace.raySeg = seg;
+  return trace();
+}
+
+bool InstanceBvh::occluded(const RaySeg &raySeg) const {
+  if (nodes.empty() || raySeg.dist <= 0.0f)
+    return false;
+
+  Vector3 inv = inverse(raySeg.d);
+  int stack[64];
+  int top = 0;
+  int current = 0;
+  while (true) {
+    const Node &node = nodes[current];
+    if (hitsBox(node.min, node.max, raySeg.p, inv, raySeg.dist)) {
+      if (!node.leaf()) {
+        stack[top++] = node.offset;
+        current = current + 1;
+        continue;
+      }
+      for (int i = node.offset; i < node.offset + node.count; i++) {
+        float scale;
+        RaySeg objectSeg = toObject(placed[i], raySeg, scale);
+        if (scale > 0.0f && placed[i].tracer->occluded(objectSeg))
+          return true;
+      }
+    }
+    if (!top)
+      break;
+    current = stack[--top];
+  }
+  return false;
+}
+
+uint32_t InstanceBvh::occluded(const RayPacket &packet) const {
+  if (nodes.empty())
+    return 0;
+
+  Vector3 origins[RayPacket::maxSize], invs[RayPacket::maxSize];
+  for (int lane = 0; lane < packet.size; lane++) {
+    origins[lane] = Vector3(packet.ox[lane], packet.oy[lane], packet.oz[lane]);
+    invs[lane] = inverse(Vector3(packet.dx[lane], packet.dy[lane], packet.dz[lane]));
+  }
+
+  // the packet goes down every node any unblocked lane reaches, and each instance gets
+  // the whole packet moved into its space with blocked lanes emptied
+  uint32_t active = packet.mask();
+  for (int lane = 0; lane < packet.size; lane++)
+    if (packet.dist[lane] <= 0.0f)
+      active &= ~(1u << lane);
+  uint32_t blocked = 0;
+  int stack[64];
+  int top = 0;
+  int current = 0;
+  while (active & ~blocked) {
+    const Node &node = nodes[current];
+    bool visit = false;
+    for (int lane = 0; lane < packet.size && !visit; lane++)
+      visit = ((active & ~blocked) >> lane & 1u) && hitsBox(node.min, node.max, origins[lane], invs[lane], packet.dist[lane]);
+    if (visit) {
+      if (!node.leaf()) {
+        stack[top++] = node.offset;
+        current = current + 1;
+        continue;
+      }
+      for (int i = node.offset; i < node.offset + node.count; i++) {
+        const Placed &p = placed[i];
+        RayPacket objectPacket;
+        for (int lane = 0; lane < packet.size; lane++) {
+          float scale;
+          RaySeg objectSeg = toObject(p, packet.get(lane), scale);
+          objectPacket.push(objectSeg);
+          if (scale <= 0.0f || !((active & ~blocked) >> lane & 1u))
+            objectPacket.dist[lane] = 0.0f;
+        }
+        blocked |= p.tracer->occluded(objectPacket) & active;
+      }
+    }
+    if (!top)
+      break;
+    current = stack[--top];
+  }
+  return blocked;
+}
+
+}
+}
+}
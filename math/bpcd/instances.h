@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tracer.h"
+
+#include <vector>
+#include <memory>
+
+namespace mbz {
+namespace math {
+namespace bpcd {
+
+// one placement of a bottom level tracer built in object space. a linear part that mirrors
+// (negative determinant) turns the triangles' front faces around, so those placements trace
+// mirroredBlas instead, built from the same triangles flipped (TriangleView::flipped())
+struct Instance {
+  std::shared_ptr<const Tracer> blas;
+  std::shared_ptr<const Tracer> mirroredBlas = nullptr;
+  Matrix3 linear;  // object to world, translation aside
+  Vector3 translation;
+  int firstIndex = 0;  // added to the triangle indices blas reports
+
+  Instance() {
+    linear.identity();
+  }
+};
+
+// two level tracer. the bottom level is one grid or bvh per unique mesh, the top level a
+// small bvh over the world bounds of the instances placing them. rays reaching an instance
+// are moved into its object space with the direction left unnormalized in length, so hit
+// distances carry over by one scale and instanced geometry is stored and built once
+struct InstanceBvh : public Tracer {
+  static constexpr int maxLeafSize = 2;
+
+  struct Node {
+    float min[3];
+    int offset;  // leaf: first instance, interior: index of the second child
+    float max[3];
+    int count;  // instances in a leaf, 0 for interior nodes
+    bool leaf() const {
+      return count > 0;
+    }
+  };
+
+  InstanceBvh(std::vector<Instance> instances);
+
+  virtual bool traceRay(RaySeg raySeg, Trace &trace) const override;
+  virtual bool occluded(const RaySeg &raySeg) const override;
+  virtual uint32_t occluded(const RayPacket &packet) const override;
+
+  virtual Aabb bounds() const override {
+    return bigBox;
+  }
+
+  size_t size() const {
+    return placed.size();
+  }
+
+ protected:
+  struct Placed {
+    Instance instance;
+    const Tracer *tracer;  // the blas the placement's winding calls for
+    bool mirrored;  // tracing mirroredBlas, whose hits have the two barycentrics swapped
+    Matrix3 toObject;
+    float min[3], max[3];
+  };
+  std::vector<Placed> placed;  // leaf order
+  std::vector<Node> nodes;
+  Aabb bigBox;
+
+  int buildNode(int begin, int end);
+  // the segment in the instance's object space and the factor from world to object
+  // distances along it
+  RaySeg toObject(const Placed &placed, const RaySeg &raySeg, float &scale) const;
+};
+
+}
+}
+}
@@ -0,0 +1,46 @@
+#include "tracer.h"
+#include "grid.h"
+#include "bvh.h"
+
+#include <cstdio>
+#include <string>
+
+namespace mbz {
+namespace math {
+namespace bpcd {
+
+uint32_t Tracer::occluded(const RayPacket &packet) const {
+  uint32_t hits = 0;
+  for (int i = 0; i < packet.size; i++) {
+    if (occluded(packet.get(i)))
+      hits |= 1u << i;
+  }
+  return hits;
+}
+
+std::shared_ptr<Tracer> createTracer(TracerType type, std::shared_ptr<utils::heap::Heap> heap, const TriangleView &trisPoints, std::optional<Vector3> cellSize, std::string_view cachePrefix) {
+  if (type == TracerType::Bvh) {
+    auto bvh = std::make_shared<Bvh>();
+    bvh->build(trisPoints);
+    return bvh;
+  }
+  auto grid = std::make_shared<Grid>(heap);
+  if (cachePrefix.empty()) {
+    grid->build(trisPoints, cellSize);
+    return grid;
+  }
+  uint64_t key = Grid::cacheKey(trisPoints, cellSize);
+  uint64_t setting = cellSize ? utils::heap::hasher64(utils::heap::hasher64(), cellSize->xyz, sizeof(cellSize->xyz)) : 0;
+  char suffix[48];
+  snprintf(suffix, sizeof(suffix), ".%08x.%016llx.grid", uint32_t(setting), (unsigned long long) key);
+  std::string cacheName = std::string(cachePrefix) + suffix;
+  if (!grid->load(cacheName, key)) {
+    grid->build(trisPoints, cellSize);
+    grid->save(cacheName, key);
+  }
+  return grid;
+}
+
+}
+}
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "../bcs.h"
+#include "../../utils/heap.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace mbz {
+namespace math {
+namespace bpcd {
+
+struct Trace {
+  RaySeg raySeg;
+  int index;
+  std::optional<BcsCoord> bcsCoord;
+  std::optional<Vector3> point;
+  Trace(const RaySeg &raySeg)
+      :
+      raySeg(raySeg),
+      index(-1),
+      bcsCoord(std::nullopt),
+      point(std::nullopt) {
+  }
+  Trace(Ray ray, float dist)
+      :
+      raySeg(ray, dist),
+      index(-1),
+      bcsCoord(std::nullopt),
+      point(std::nullopt) {
+  }
+  bool operator()() const {
+    return bcsCoord.has_value() && bcsCoord.value().inside();
+  }
+};
+
+// up to 16 rays traced together. lanes are stored as structure of arrays so tracers
+// can test a triangle or a box against several rays per instruction
+struct RayPacket {
+  static constexpr int maxSize = 16;
+  alignas(32) float ox[maxSize];
+  alignas(32) float oy[maxSize];
+  alignas(32) float oz[maxSize];
+  alignas(32) float dx[maxSize];
+  alignas(32) float dy[maxSize];
+  alignas(32) float dz[maxSize];
+  alignas(32) float dist[maxSize];
+  int size = 0;
+
+  RayPacket() {
+    clear();
+  }
+
+  void clear() {
+    size = 0;
+    for (int i = 0; i < maxSize; i++) {
+      ox[i] = oy[i] = oz[i] = 0.0f;
+      dx[i] = dy[i] = dz[i] = 0.0f;
+      dist[i] = 0.0f;  // empty lanes never hit
+    }
+  }
+
+  bool push(const RaySeg &raySeg) {
+    if (size == maxSize)
+      return false;
+    ox[size] = raySeg.p.x;
+    oy[size] = raySeg.p.y;
+    oz[size] = raySeg.p.z;
+    dx[size] = raySeg.d.x;
+    dy[size] = raySeg.d.y;
+    dz[size] = raySeg.d.z;
+    dist[size] = raySeg.dist;
+    size++;
+    return true;
+  }
+
+  RaySeg get(int lane) const {
+    RaySeg raySeg(Ray(), dist[lane]);
+    raySeg.p = Vector3(ox[lane], oy[lane], oz[lane]);
+    raySeg.d = Vector3(dx[lane], dy[lane], dz[lane]);
+    return raySeg;
+  }
+
+  uint32_t mask() const {
+    return (1u << size) - 1u;
+  }
+};
+
+// the triangles a tracer is built from, read in place: either corner triples or positions
+// picked out of a vertex array by an index buffer, so indexed meshes need no flattened copy
+// of their corners. strides are in bytes for positions and in ints for indices
+class TriangleView {
+ public:
+  TriangleView(const std::vector<std::array<Vector3, 3>> &trisPoints)
+      :
+      positions(reinterpret_cast<const uint8_t*>(trisPoints.data())),
+      positionStride(sizeof(Vector3)),
+      count(trisPoints.size()) {
+  }
+
+  TriangleView(const Vector3 *positions, size_t positionStride, const int *indices, size_t indexStride, size_t count)
+      :
+      positions(reinterpret_cast<const uint8_t*>(positions)),
+      positionStride(positionStride),
+      indices(indices),
+      indexStride(indexStride),
+      count(count) {
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  std::array<Vector3, 3> operator[](size_t i) const {
+    size_t corners[3] = { 3 * i, 3 * i + 1, 3 * i + 2 };
+    if (indices) {
+      const int *tri = indices + i * indexStride;
+      for (int j = 0; j < 3; j++)
+        corners[j] = size_t(tri[j]);
+    }
+    if (flip)
+      return { position(corners[0]), position(corners[2]), position(corners[1]) };
+    return { position(corners[0]), position(corners[1]), position(corners[2]) };
+  }
+
+  // the same triangles wound the other way, their last two corners swapped. what a mirroring
+  // instance traces, since the tracers only hit front faces
+  TriangleView flipped() const {
+    TriangleView view = *this;
+    view.flip = !flip;
+    return view;
+  }
+
+ private:
+  const uint8_t *positions = nullptr;
+  size_t positionStride = 0;
+  const int *indices = nullptr;
+  size_t indexStride = 3;
+  size_t count = 0;
+  bool flip = false;
+
+  const Vector3& position(size_t vertex) const {
+    return *reinterpret_cast<const Vector3*>(positions + vertex * positionStride);
+  }
+};
+
+// common interface of the ray query structures, so solvers can swap one for another
+struct Tracer {
+  virtual ~Tracer() = default;
+  virtual bool traceRay(RaySeg raySeg, Trace &trace) const = 0;
+  // any-hit query, returns at the first triangle found along the segment
+  virtual bool occluded(const RaySeg &raySeg) const = 0;
+  // any-hit query for a whole packet, bit i of the result is set when lane i is blocked
+  virtual uint32_t occluded(const RayPacket &packet) const;
+  virtual Aabb bounds() const = 0;
+};
+
+enum class TracerType {
+  Grid,
+  Bvh,
+};
+
+// cellSize only applies to grids, which pick their own resolution without one. grids are
+// cached in <cachePrefix>.<cell size hash>.<key>.grid, mapped when the key matches and
+// written otherwise. every cell size keeps a file of its own, and saving a new key
+// removes the file of the last geometry built at that cell size
+std::shared_ptr<Tracer> createTracer(TracerType type, std::shared_ptr<utils::heap::Heap> heap, const TriangleView &trisPoints, std::optional<Vector3> cellSize = std::nullopt, std::string_view cachePrefix = "");
+
+}
+}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../bcs.h"
+
+#include <cmath>
+#include <utility>
+
+namespace mbz {
+namespace math {
+namespace bpcd {
+
+// a ray set up for the watertight test of woop, benthin and wald: the axis it travels
+// along most becomes z and the other two are sheared so the ray runs straight down it
+struct WatertightRay {
+  Vector3 o, d;
+  int kx, ky, kz;
+  float sx, sy;
+  float dist;
+
+  WatertightRay() = default;
+  WatertightRay(const RaySeg &raySeg)
+      :
+      o(raySeg.p),
+      d(raySeg.d),
+      dist(raySeg.dist) {
+    kz = fabsf(d.x) > fabsf(d.y) ? (fabsf(d.x) > fabsf(d.z) ? 0 : 2) : (fabsf(d.y) > fabsf(d.z) ? 1 : 2);
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+    // keep the winding of the projected triangle when looking down -z
+    if (d.xyz[kz] < 0.0f)
+      std::swap(kx, ky);
+    sx = d.xyz[kx] / d.xyz[kz];
+    sy = d.xyz[ky] / d.xyz[kz];
+  }
+};
+
+// intersection-only triangle record. one cache line holds the vertices, the unnormalized
+// face normal the hit distance is taken from and the source triangle index
+struct alignas(64) Triangle {
+  Vector3 v0, v1, v2;
+  Vector3 n;
+  int index;
+
+  void init(const Vector3 &p, const Vector3 &p2, const Vector3 &p3, int index_) {
+    v0 = p;
+    v1 = p2;
+    v2 = p3;
+    n = p.point(p2).cross(p.point(p3));
+    index = index_;
+  }
+
+  // front faces only, like Bcs3::project. edges shared by two triangles are decided the
+  // same way for both, so rays never slip between them. on a hit t is the distance along
+  // the ray and coord the barycentric coordinate along v1 - v0 and v2 - v0
+  bool intersect(const WatertightRay &ray, float &t, BcsCoord &coord) const {
+    Vector3 a = v0 - ray.o;
+    Vector3 b = v1 - ray.o;
+    Vector3 c = v2 - ray.o;
+    float ax = a.xyz[ray.kx] - ray.sx * a.xyz[ray.kz];
+    float ay = a.xyz[ray.ky] - ray.sy * a.xyz[ray.kz];
+    float bx = b.xyz[ray.kx] - ray.sx * b.xyz[ray.kz];
+    float by = b.xyz[ray.ky] - ray.sy * b.xyz[ray.kz];
+    float cx = c.xyz[ray.kx] - ray.sx * c.xyz[ray.kz];
+    float cy = c.xyz[ray.ky] - ray.sy * c.xyz[ray.kz];
+
+    float u = cx * by - cy * bx;
+    float v = ax * cy - ay * cx;
+    float w = bx * ay - by * ax;
+    // an edge passing exactly through the ray is resolved in double precision
+    if (u == 0.0f || v == 0.0f || w == 0.0f) {
+      u = float(double(cx) * double(by) - double(cy) * double(bx));
+      v = float(double(ax) * double(cy) - double(ay) * double(cx));
+      w = float(double(bx) * double(ay) - double(by) * double(ax));
+    }
+    if (u < 0.0f || v < 0.0f || w < 0.0f)
+      return false;
+    float det = u + v + w;
+    if (det == 0.0f)
+      return false;
+
+    // distance to the plane, taken exactly as the packet test does so both agree on rays
+    // that start on the triangle
+    float ddotn = ray.d.dot(n);
+    float adotn = a.dot(n);
+    if (ddotn >= 0.0f || adotn >= 0.0f || adotn < ray.dist * ddotn)
+      return false;
+    t = adotn / ddotn;
+    float inv = 1.0f / det;
+    coord.x = v * inv;
+    coord.y = w * inv;
+    return true;
+  }
+
+  bool hits(const WatertightRay &ray) const {
+    float t;
+    BcsCoord coord;
+    return intersect(ray, t, coord);
+  }
+};
+static_assert(sizeof(Triangle) == 64, "bpcd::Triangle should fill one cache line");
+
+}
+}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+// monte carlo sample generation in float: a stateless counter hash and a small pcg32
+// stream for random numbers, scrambled sobol, halton and r2 sequences plus interleaved
+// gradient noise for low discrepancy and blue noise like patterns, and the cosine
+// weighted hemisphere mapping the solvers trace with
+
+#include "vector.h"
+
+#include <cmath>
+#include <cstdint>
+
+namespace mbz {
+namespace math {
+namespace sampling {
+
+// pcg output permutation of a single lcg step (jarzynski and olano), a good 32 bit hash
+inline uint32_t pcgHash(uint32_t v) {
+  uint32_t state = v * 747796405u + 2891336453u;
+  uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+// counter based random bits: the same key and counter always give the same value, so a
+// stream can be keyed by whatever identifies the work rather than by who runs it
+inline uint32_t random(uint32_t key, uint32_t counter) {
+  return pcgHash(counter + pcgHash(key));
+}
+
+// top 24 bits to a float in [0, 1)
+inline float toUnit(uint32_t bits) {
+  return float(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// minimal pcg32 (o'neill), 64 bits of state and a per stream increment
+struct Pcg32 {
+  uint64_t state = 0;
+  uint64_t inc = 1;
+
+  Pcg32(uint64_t seed_ = 0x853c49e6748fea9bull, uint64_t stream_ = 0xda3e39cb94b95bdbull) {
+    seed(seed_, stream_);
+  }
+
+  void seed(uint64_t seed_, uint64_t stream_ = 0xda3e39cb94b95bdbull) {
+    state = 0;
+    inc = (stream_ << 1u) | 1u;
+    next();
+    state += seed_;
+    next();
+  }
+
+  uint32_t next() {
+    uint64_t old = state;
+    state = old * 6364136223846793005ull + inc;
+    uint32_t shifted = uint32_t(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = uint32_t(old >> 59u);
+    return (shifted >> rot) | (shifted << ((0u - rot) & 31u));
+  }
+
+  float uniform() {
+    return toUnit(next());
+  }
+};
+
+inline uint32_t reverseBits(uint32_t v) {
+  v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+  v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+  v = ((v >> 4) & 0x0f0f0f0fu) | ((v & 0x0f0f0f0fu) << 4);
+  v = ((v >> 8) & 0x00ff00ffu) | ((v & 0x00ff00ffu) << 8);
+  return (v >> 16) | (v << 16);
+}
+
+// first two sobol dimensions of point i as 32 bit fractions, xor scrambled by shift.
+// the shift keeps every power of two prefix a (0, m, 2) net, so per texel shifts
+// decorrelate texels without losing stratification
+inline Vector2 sobol(uint32_t i, uint32_t shiftX = 0, uint32_t shiftY = 0) {
+  uint32_t y = 0;
+  for (uint32_t bits = i, v = 1u << 31; bits; bits >>= 1, v ^= v >> 1)
+    if (bits & 1u)
+      y ^= v;
+  return Vector2(toUnit(reverseBits(i) ^ shiftX), toUnit(y ^ shiftY));
+}
+
+inline float radicalInverse(uint32_t i, uint32_t base) {
+  float inverse = 1.0f / float(base), scale = inverse, result = 0.0f;
+  for (; i; i /= base, scale *= inverse)
+    result += float(i % base) * scale;
+  return result;
+}
+
+// halton point i in bases 2 and 3
+inline Vector2 halton(uint32_t i) {
+  return Vector2(toUnit(reverseBits(i)), radicalInverse(i, 3));
+}
+
+// r2 point i (roberts), rotated by offset
+inline Vector2 r2(uint32_t i, Vector2 offset = Vector2(0.5f, 0.5f)) {
+  constexpr double g = 1.32471795724474602596;
+  constexpr float a1 = float(1.0 / g), a2 = float(1.0 / (g * g));
+  float x = offset.x + a1 * float(i), y = offset.y + a2 * float(i);
+  return Vector2(x - std::floor(x), y - std::floor(y));
+}
+
+// interleaved gradient noise (jimenez), a cheap blue noise like value per pixel
+inline float interleavedGradientNoise(float x, float y) {
+  float f = 0.06711056f * x + 0.00583715f * y;
+  f = 52.9829189f * (f - std::floor(f));
+  return f - std::floor(f);
+}
+
+// uniform direction on the unit sphere from a point of the unit square
+inline Vector3 uniformSphere(Vector2 u) {
+  float z = 1.0f - 2.0f * u.x;
+  float r = std::sqrt(std::fmax(0.0f, 1.0f - z * z));
+  float phi = 2.0f * Pi * u.y;
+  return Vector3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+// cosine weighted direction around +z from a point of the unit square, pdf cos / pi
+inline Vector3 cosineHemisphere(Vector2 u) {
+  float r = std::sqrt(u.x);
+  float phi = 2.0f * Pi * u.y;
+  return Vector3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::fmax(0.0f, 1.0f - u.x)));
+}
+
+// the same mapping over arrays, laid out so the loop vectorizes
+inline void cosineHemisphere(const float *u0, const float *u1, int count, float *x, float *y, float *z) {
+  for (int i = 0; i < count; i++) {
+    float r = std::sqrt(u0[i]);
+    float phi = 2.0f * Pi * u1[i];
+    x[i] = r * std::cos(phi);
+    y[i] = r * std::sin(phi);
+    z[i] = std::sqrt(std::fmax(0.0f, 1.0f - u0[i]));
+  }
+}
+
+// orthonormal basis around a unit normal without branches on its direction (duff et al.)
+struct Frame {
+  Vector3 t, b, n;
+
+  Frame(const Vector3 &n_)
+      :
+      n(n_) {
+    float sign = std::copysign(1.0f, n.z);
+    float a = -1.0f / (sign + n.z);
+    float c = n.x * n.y * a;
+    t = Vector3(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+    b = Vector3(c, sign + n.y * n.y * a, -n.y);
+  }
+
+  Vector3 toWorld(const Vector3 &v) const {
+    return Vector3(t.x * v.x + b.x * v.y + n.x * v.z, t.y * v.x + b.y * v.y + n.y * v.z, t.z * v.x + b.z * v.y + n.z * v.z);
+  }
+};
+
+}
+}
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+// thin wrapper over the widest float lanes the target was compiled for:
+// 8 lanes with AVX, 4 with SSE and a single scalar lane otherwise. 32 bit integer
+// lanes are 8 wide with AVX2, 4 with SSE2 and scalar otherwise
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MBZ_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MBZ_SIMD_SSE
+#endif
+
+#include <cstdint>
+
+namespace mbz {
+namespace math {
+namespace simd {
+
+#if defined(MBZ_SIMD_AVX)
+
+constexpr int width = 8;
+
+struct Float {
+  __m256 v;
+  Float() = default;
+  Float(__m256 v_)
+      :
+      v(v_) {
+  }
+  Float(float f)
+      :
+      v(_mm256_set1_ps(f)) {
+  }
+  static Float load(const float *p) {
+    return _mm256_load_ps(p);
+  }
+  void store(float *p) const {
+    _mm256_store_ps(p, v);
+  }
+};
+
+inline Float operator +(Float a, Float b) { return _mm256_add_ps(a.v, b.v); }
+inline Float operator -(Float a, Float b) { return _mm256_sub_ps(a.v, b.v); }
+inline Float operator *(Float a, Float b) { return _mm256_mul_ps(a.v, b.v); }
+inline Float operator /(Float a, Float b) { return _mm256_div_ps(a.v, b.v); }
+inline Float min(Float a, Float b) { return _mm256_min_ps(a.v, b.v); }
+inline Float max(Float a, Float b) { return _mm256_max_ps(a.v, b.v); }
+inline Float operator <(Float a, Float b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline Float operator <=(Float a, Float b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline Float operator >(Float a, Float b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline Float operator >=(Float a, Float b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline Float operator &(Float a, Float b) { return _mm256_and_ps(a.v, b.v); }
+inline Float operator |(Float a, Float b) { return _mm256_or_ps(a.v, b.v); }
+inline Float select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+inline uint32_t mask(Float a) { return uint32_t(_mm256_movemask_ps(a.v)); }
+
+#elif defined(MBZ_SIMD_SSE)
+
+constexpr int width = 4;
+
+struct Float {
+  __m128 v;
+  Float() = default;
+  Float(__m128 v_)
+      :
+      v(v_) {
+  }
+  Float(float f)
+      :
+      v(_mm_set1_ps(f)) {
+  }
+  static Float load(const float *p) {
+    return _mm_load_ps(p);
+  }
+  void store(float *p) const {
+    _mm_store_ps(p, v);
+  }
+};
+
+inline Float operator +(Float a, Float b) { return _mm_add_ps(a.v, b.v); }
+inline Float operator -(Float a, Float b) { return _mm_sub_ps(a.v, b.v); }
+inline Float operator *(Float a, Float b) { return _mm_mul_ps(a.v, b.v); }
+inline Float operator /(Float a, Float b) { return _mm_div_ps(a.v, b.v); }
+inline Float min(Float a, Float b) { return _mm_min_ps(a.v, b.v); }
+inline Float max(Float a, Float b) { return _mm_max_ps(a.v, b.v); }
+inline Float operator <(Float a, Float b) { return _mm_cmplt_ps(a.v, b.v); }
+inline Float operator <=(Float a, Float b) { return _mm_cmple_ps(a.v, b.v); }
+inline Float operator >(Float a, Float b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline Float operator >=(Float a, Float b) { return _mm_cmpge_ps(a.v, b.v); }
+inline Float operator &(Float a, Float b) { return _mm_and_ps(a.v, b.v); }
+inline Float operator |(Float a, Float b) { return _mm_or_ps(a.v, b.v); }
+inline Float select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+inline uint32_t mask(Float a) { return uint32_t(_mm_movemask_ps(a.v)); }
+
+#else
+
+constexpr int width = 1;
+
+// comparisons yield 1.0f for true and 0.0f for false
+struct Float {
+  float v;
+  Float() = default;
+  Float(float f)
+      :
+      v(f) {
+  }
+  static Float load(const float *p) {
+    return *p;
+  }
+  void store(float *p) const {
+    *p = v;
+  }
+};
+
+inline Float operator +(Float a, Float b) { return a.v + b.v; }
+inline Float operator -(Float a, Float b) { return a.v - b.v; }
+inline Float operator *(Float a, Float b) { return a.v * b.v; }
+inline Float operator /(Float a, Float b) { return a.v / b.v; }
+inline Float min(Float a, Float b) { return a.v < b.v ? a.v : b.v; }
+inline Float max(Float a, Float b) { return a.v > b.v ? a.v : b.v; }
+inline Float operator <(Float a, Float b) { return a.v < b.v ? 1.0f : 0.0f; }
+inline Float operator <=(Float a, Float b) { return a.v <= b.v ? 1.0f : 0.0f; }
+inline Float operator >(Float a, Float b) { return a.v > b.v ? 1.0f : 0.0f; }
+inline Float operator >=(Float a, Float b) { return a.v >= b.v ? 1.0f : 0.0f; }
+inline Float operator &(Float a, Float b) { return a.v != 0.0f && b.v != 0.0f ? 1.0f : 0.0f; }
+inline Float operator |(Float a, Float b) { return a.v != 0.0f || b.v != 0.0f ? 1.0f : 0.0f; }
+inline Float select(Float mask, Float a, Float b) { return mask.v != 0.0f ? a : b; }
+inline uint32_t mask(Float a) { return a.v != 0.0f ? 1u : 0u; }
+
+#endif
+
+#if defined(__AVX2__)
+
+constexpr int intWidth = 8;
+
+struct Int {
+  __m256i v;
+  Int() = default;
+  Int(__m256i v_)
+      :
+      v(v_) {
+  }
+  Int(int32_t i)
+      :
+      v(_mm256_set1_epi32(i)) {
+  }
+  static Int load(const int32_t *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+};
+
+inline Int operator +(Int a, Int b) { return _mm256_add_epi32(a.v, b.v); }
+inline Int operator -(Int a, Int b) { return _mm256_sub_epi32(a.v, b.v); }
+inline Int operator >(Int a, Int b) { return _mm256_cmpgt_epi32(a.v, b.v); }
+inline Int operator &(Int a, Int b) { return _mm256_and_si256(a.v, b.v); }
+inline uint32_t mask(Int a) { return uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(a.v))); }
+
+#elif defined(MBZ_SIMD_AVX) || defined(MBZ_SIMD_SSE)
+
+constexpr int intWidth = 4;
+
+struct Int {
+  __m128i v;
+  Int() = default;
+  Int(__m128i v_)
+      :
+      v(v_) {
+  }
+  Int(int32_t i)
+      :
+      v(_mm_set1_epi32(i)) {
+  }
+  static Int load(const int32_t *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+};
+
+inline Int operator +(Int a, Int b) { return _mm_add_epi32(a.v, b.v); }
+inline Int operator -(Int a, Int b) { return _mm_sub_epi32(a.v, b.v); }
+inline Int operator >(Int a, Int b) { return _mm_cmpgt_epi32(a.v, b.v); }
+inline Int operator &(Int a, Int b) { return _mm_and_si128(a.v, b.v); }
+inline uint32_t mask(Int a) { return uint32_t(_mm_movemask_ps(_mm_castsi128_ps(a.v))); }
+
+#else
+
+constexpr int intWidth = 1;
+
+// comparisons yield -1 for true and 0 for false
+struct Int {
+  int32_t v;
+  Int() = default;
+  Int(int32_t i)
+      :
+      v(i) {
+  }
+  static Int load(const int32_t *p) {
+    return *p;
+  }
+};
+
+inline Int operator +(Int a, Int b) { return a.v + b.v; }
+inline Int operator -(Int a, Int b) { return a.v - b.v; }
+inline Int operator >(Int a, Int b) { return a.v > b.v ? -1 : 0; }
+inline Int operator &(Int a, Int b) { return a.v & b.v; }
+inline uint32_t mask(Int a) { return a.v != 0 ? 1u : 0u; }
+
+#endif
+
+}
+}
+}
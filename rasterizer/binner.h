@@ -0,0 +1,136 @@
+#pragma once
+
+#include "raster.h"
+#include "../utils/heap.h"
+#include "../utils/workers.h"
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace mbz {
+namespace rasterizer {
+
+// tile parallel front end to Raster. triangles are queued with add(), and flush() bins
+// them into binSize x binSize squares of the target in one pass before rasterizing the
+// bins on the shared pool, each clipped to its own square. bins never share a texel, so
+// nothing is locked, within a bin triangles are drawn in the order they were added and
+// the result matches drawing them all through one Raster
+template<typename Buffer>
+class BinnedRaster {
+ public:
+  using Target = Buffer;
+  using Vertex = typename Raster<Buffer>::Vertex;
+  static constexpr int binSize = 64;
+  static_assert(binSize % Raster<Buffer>::tileSize == 0, "BinnedRaster bins must hold whole raster tiles");
+
+  bool conservative = false;  // see Raster::conservative
+
+  BinnedRaster(Target &target, std::shared_ptr<utils::heap::Heap> heap)
+      :
+      target(target),
+      heap(heap),
+      binsX((int(target.w) + binSize - 1) / binSize),
+      binsY((int(target.h) + binSize - 1) / binSize),
+      bins(size_t(binsX) * binsY) {
+  }
+
+  void add(const Vertex &v0, const Vertex &v1, const Vertex &v2) {
+    tris.push_back( { v0, v1, v2 });
+  }
+
+  size_t size() const {
+    return tris.size();
+  }
+
+  // rasterizes and drops every queued triangle, returns the number of texels written
+  int flush() {
+    if (tris.empty())
+      return 0;
+    binTriangles();
+
+    struct BinTask : public utils::multithread::Task {
+      BinnedRaster *binned;
+      int bin;
+      int written = 0;
+      virtual void perform(utils::multithread::Toolbox *toolbox) override {
+        written = binned->drawBin(bin);
+      }
+    };
+    int numTasks = 0;
+    for (auto &bin : bins)
+      numTasks += bin.empty() ? 0 : 1;
+    if (!numTasks) {
+      tris.clear();
+      return 0;
+    }
+    utils::multithread::Workers workers(heap, uint32_t(numTasks));
+    for (int i = 0; i < int(bins.size()); i++) {
+      if (bins[i].empty())
+        continue;
+      auto task = std::make_unique<BinTask>();
+      task->binned = this;
+      task->bin = i;
+      workers.todo.append_move(std::move(task));
+    }
+    workers.beginJoin();
+
+    int written = 0;
+    for (int i = 0; i < workers.completed.size; i++) {
+      written += static_cast<BinTask*>(workers.completed.p()[i].get())->written;
+      workers.completed.p()[i].reset();
+    }
+    workers.completed.size = 0;
+    for (auto &bin : bins)
+      bin.clear();
+    tris.clear();
+    return written;
+  }
+
+ protected:
+  Target &target;
+  std::shared_ptr<utils::heap::Heap> heap;
+  int binsX, binsY;
+  std::vector<std::array<Vertex, 3>> tris;
+  std::vector<std::vector<uint32_t>> bins;  // triangle indices per bin, kept between flushes
+
+  // a triangle covers texels between the floor and ceiling of its bounds, vertex snapping
+  // included (a texel further out when conservative), so it goes to every bin that range
+  // touches
+  void binTriangles() {
+    float grow = conservative ? 1.0f : 0.0f;
+    for (size_t t = 0; t < tris.size(); t++) {
+      const auto &tri = tris[t];
+      float minX = std::min(tri[0].p.x, std::min(tri[1].p.x, tri[2].p.x)) - grow;
+      float maxX = std::max(tri[0].p.x, std::max(tri[1].p.x, tri[2].p.x)) + grow;
+      float minY = std::min(tri[0].p.y, std::min(tri[1].p.y, tri[2].p.y)) - grow;
+      float maxY = std::max(tri[0].p.y, std::max(tri[1].p.y, tri[2].p.y)) + grow;
+      if (!(maxX >= 0.0f && maxY >= 0.0f && minX <= float(target.w) && minY <= float(target.h)))
+        continue;
+      int bx0 = int(std::max(0.0f, floorf(minX))) / binSize;
+      int by0 = int(std::max(0.0f, floorf(minY))) / binSize;
+      int bx1 = std::min(binsX - 1, int(std::min(float(target.w), ceilf(maxX))) / binSize);
+      int by1 = std::min(binsY - 1, int(std::min(float(target.h), ceilf(maxY))) / binSize);
+      for (int by = by0; by <= by1; by++)
+        for (int bx = bx0; bx <= bx1; bx++)
+          bins[size_t(by) * binsX + bx].push_back(uint32_t(t));
+    }
+  }
+
+  int drawBin(int bin) {
+    int bx = bin % binsX, by = bin / binsX;
+    Raster<Buffer> raster(target);
+    raster.conservative = conservative;
+    raster.clip(bx * binSize, by * binSize, bx * binSize + binSize - 1, by * binSize + binSize - 1);
+    int written = 0;
+    for (uint32_t t : bins[bin])
+      written += raster.draw(tris[t][0], tris[t][1], tris[t][2]);
+    return written;
+  }
+};
+
+}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "gbuffer.h"
+#include "../utils/heap.h"
+#include "../utils/workers.h"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace mbz {
+namespace rasterizer {
+
+namespace detail {
+
+template<typename ... Ts, size_t ... Is>
+void copyTexel(GBuffer<Ts...> &gbuffer, size_t to, size_t from, std::index_sequence<Is...>) {
+  ((gbuffer.template at<Is>(to) = gbuffer.template at<Is>(from)), ...);
+}
+
+}
+
+// grows the drawn texels of a gbuffer outwards by up to passes texels, so filtering and
+// bilinear lookups near chart borders read the nearest drawn texel instead of empty space.
+// layer 0 is the mask and holds 0 wherever nothing was drawn. every pass first picks, for
+// each empty texel, a drawn neighbour (edge neighbours before corner ones) and then copies
+// all of that neighbour's layers over. both steps run a band of rows per task and the
+// scan is branch free along each row. returns the number of texels filled
+template<typename ... Ts>
+int dilate(GBuffer<Ts...> &gbuffer, int passes, std::shared_ptr<utils::heap::Heap> heap) {
+  using Mask = typename GBuffer<Ts...>::template Type<0>;
+  static_assert(std::is_arithmetic<Mask>::value, "dilate() needs a numeric mask in layer 0");
+  constexpr int bandRows = 32;
+
+  int w = int(gbuffer.w), h = int(gbuffer.h);
+  if (passes <= 0 || w == 0 || h == 0)
+    return 0;
+  int numBands = (h + bandRows - 1) / bandRows;
+  std::vector<int32_t> from(gbuffer.size());  // source texel of each empty texel, or -1
+  std::vector<int> filled(numBands);
+
+  struct BandTask : public utils::multithread::Task {
+    GBuffer<Ts...> *gbuffer;
+    int32_t *from;
+    int *filled;
+    int y0, y1;
+    bool scan;
+
+    virtual void perform(utils::multithread::Toolbox *toolbox) override {
+      if (scan)
+        pick();
+      else
+        copy();
+    }
+
+    void pick() {
+      int w = int(gbuffer->w), h = int(gbuffer->h);
+      const Mask *mask = gbuffer->template layer<0>();
+      for (int y = y0; y < y1; y++) {
+        const Mask *row = mask + size_t(y) * w;
+        // rows outside the buffer read as the current row, which adds no candidates
+        int up = y > 0 ? -w : 0, down = y + 1 < h ? w : 0;
+        int32_t *out = from + size_t(y) * w;
+        int32_t base = y * w;
+        for (int x = 0; x < w; x++) {
+          int left = x > 0 ? -1 : 0, right = x + 1 < w ? 1 : 0;
+          // lowest priority first, each later candidate overrides
+          int32_t f = -1;
+          f = row[x + down + right] != Mask(0) ? base + x + down + right : f;
+          f = row[x + down + left] != Mask(0) ? base + x + down + left : f;
+          f = row[x + up + right] != Mask(0) ? base + x + up + right : f;
+          f = row[x + up + left] != Mask(0) ? base + x + up + left : f;
+          f = row[x + down] != Mask(0) ? base + x + down : f;
+          f = row[x + up] != Mask(0) ? base + x + up : f;
+          f = row[x + right] != Mask(0) ? base + x + right : f;
+          f = row[x + left] != Mask(0) ? base + x + left : f;
+          out[x] = row[x] != Mask(0) ? -1 : f;
+        }
+      }
+    }
+
+    void copy() {
+      int w = int(gbuffer->w);
+      for (size_t i = size_t(y0) * w; i < size_t(y1) * w; i++) {
+        if (from[i] < 0)
+          continue;
+        detail::copyTexel(*gbuffer, i, size_t(from[i]), std::index_sequence_for<Ts...>());
+        (*filled)++;
+      }
+    }
+  };
+
+  // texels a pass copies from are drawn, and drawn texels are never written, so neither
+  // step needs a second buffer
+  utils::multithread::Workers workers(heap, uint32_t(numBands));
+  int total = 0;
+  for (int pass = 0; pass < passes; pass++) {
+    for (bool scan : { true, false }) {
+      for (int b = 0; b < numBands; b++) {
+        auto task = std::make_unique<BandTask>();
+        task->gbuffer = &gbuffer;
+        task->from = from.data();
+        task->filled = &filled[b];
+        task->y0 = b * bandRows;
+        task->y1 = std::min(h, task->y0 + bandRows);
+        task->scan = scan;
+        workers.todo.append_move(std::move(task));
+      }
+      workers.beginJoin();
+      for (int i = 0; i < workers.completed.size; i++)
+        workers.completed.p()[i].reset();
+      workers.completed.size = 0;
+    }
+    int count = 0;
+    for (int &n : filled) {
+      count += n;
+      n = 0;
+    }
+    total += count;
+    if (!count)
+      break;
+  }
+  return total;
+}
+
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "texture.h"
+
+#include <tuple>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+namespace mbz {
+namespace rasterizer {
+
+// dense per texel layers whose types are fixed at compile time, one plain array per
+// layer. a GBuffer<float, Vector3> holds 16 bytes per texel and nothing else, so solvers
+// can stream (or load into simd lanes) a single layer without touching the others
+template<typename ... Ts>
+struct GBuffer {
+  static_assert(sizeof...(Ts) > 0, "GBuffer needs at least one layer");
+  static_assert((std::is_copy_assignable<Ts>::value && ...), "GBuffer layers hold plain values");
+
+  static constexpr size_t numLayers = sizeof...(Ts);
+  template<size_t N> using Type = typename std::tuple_element<N, std::tuple<Ts...>>::type;
+
+  uint32_t w = 0, h = 0;
+
+  GBuffer(uint32_t w, uint32_t h) {
+    resize(w, h);
+  }
+
+  void resize(uint32_t w, uint32_t h) {
+    this->w = w;
+    this->h = h;
+    std::apply([&](auto &... layer) {
+      (layer.assign(size_t(w) * h, typename std::decay<decltype(layer)>::type::value_type()), ...);
+    }, layers);
+  }
+
+  // resets every texel of every layer to its default value
+  void clear() {
+    resize(w, h);
+  }
+
+  size_t size() const {
+    return size_t(w) * h;
+  }
+
+  size_t xy(int32_t x, int32_t y) const {
+    x = std::clamp(x, 0, int32_t(w - 1));
+    y = std::clamp(y, 0, int32_t(h - 1));
+    return size_t(y) * w + size_t(x);
+  }
+
+  template<size_t N> Type<N>* layer() {
+    static_assert(N < numLayers, "GBuffer::layer N oob");
+    return std::get<N>(layers).data();
+  }
+  template<size_t N> const Type<N>* layer() const {
+    static_assert(N < numLayers, "GBuffer::layer N oob");
+    return std::get<N>(layers).data();
+  }
+
+  template<size_t N> Type<N>& at(size_t index) {
+    return layer<N>()[index];
+  }
+  template<size_t N> const Type<N>& at(size_t index) const {
+    return layer<N>()[index];
+  }
+
+  static constexpr size_t bytesPerTexel() {
+    return (sizeof(Ts) + ...);
+  }
+
+ protected:
+  std::tuple<std::vector<Ts>...> layers;
+};
+
+}
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "gbuffer.h"
+#include "../math/vector.h"
+#include "../math/simd.h"
+
+#include <array>
+#include <tuple>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace mbz {
+namespace rasterizer {
+
+// how a gbuffer value is interpolated: its size floats are spread linearly across the
+// triangle and pack() rebuilds the value from them, taking whatever is not interpolated
+// from the first vertex
+template<typename T> struct Interpolant;
+
+template<> struct Interpolant<float> {
+  static constexpr int size = 1;
+  static void unpack(const float &v, float *out) {
+    out[0] = v;
+  }
+  static void pack(const float *in, const float &first, float &v) {
+    v = in[0];
+  }
+};
+
+template<> struct Interpolant<math::Vector2> {
+  static constexpr int size = 2;
+  static void unpack(const math::Vector2 &v, float *out) {
+    out[0] = v.x;
+    out[1] = v.y;
+  }
+  static void pack(const float *in, const math::Vector2 &first, math::Vector2 &v) {
+    v.x = in[0];
+    v.y = in[1];
+  }
+};
+
+template<> struct Interpolant<math::Vector3> {
+  static constexpr int size = 3;
+  static void unpack(const math::Vector3 &v, float *out) {
+    out[0] = v.x;
+    out[1] = v.y;
+    out[2] = v.z;
+  }
+  static void pack(const float *in, const math::Vector3 &first, math::Vector3 &v) {
+    v.x = in[0];
+    v.y = in[1];
+    v.z = in[2];
+  }
+};
+
+// the texture and mip level are the same across a triangle, only uv varies
+template<> struct Interpolant<PackedTexel> {
+  static constexpr int size = 2;
+  static void unpack(const PackedTexel &v, float *out) {
+    out[0] = v.uv.x;
+    out[1] = v.uv.y;
+  }
+  static void pack(const float *in, const PackedTexel &first, PackedTexel &v) {
+    v.uv.x = in[0];
+    v.uv.y = in[1];
+    v.textureHandle = first.textureHandle;
+    v.mipLevel = first.mipLevel;
+  }
+};
+
+template<typename Buffer> class Raster;
+
+// half-space triangle rasterizer writing every layer of a GBuffer<Ts...>. vertices snap to
+// 1/16 of a texel and the edge functions are exact integers, evaluated over 8 x 8 tiles:
+// tiles outside an edge are skipped, tiles inside all three are filled without testing and
+// the rest test a whole row of texels per simd instruction. a texel is covered when its
+// integer coordinate lies in the triangle; one on an edge belongs to the triangle only if
+// that is a top or left edge, so triangles sharing an edge cover each texel once. both
+// windings are drawn
+template<typename ... Ts>
+class Raster<GBuffer<Ts...>> {
+ public:
+  using Target = GBuffer<Ts...>;
+  static constexpr int numValues = (Interpolant<Ts>::size + ...);
+  static constexpr int subBits = 4;
+  static constexpr int tileSize = 8;
+
+  // when set, a texel is drawn if any of its square touches the triangle rather than only
+  // its center, with values extrapolated. neighbouring triangles then overlap by a texel
+  // and the one drawn last wins
+  bool conservative = false;
+
+  struct Vertex {
+    math::Vector2 p;
+    std::tuple<Ts...> values;
+  };
+
+  Raster(Target &target)
+      :
+      target(target),
+      clipX1(int(target.w) - 1),
+      clipY1(int(target.h) - 1) {
+  }
+
+  // limits drawing to the texels in [x0, x1] x [y0, y1], inclusive. coverage does not
+  // depend on the clip, so triangles drawn clip by clip write the same texels as unclipped
+  void clip(int x0, int y0, int x1, int y1) {
+    clipX0 = std::max(x0, 0);
+    clipY0 = std::max(y0, 0);
+    clipX1 = std::min(x1, int(target.w) - 1);
+    clipY1 = std::min(y1, int(target.h) - 1);
+  }
+
+  // returns the number of texels written
+  int draw(const Vertex &v0, const Vertex &v1, const Vertex &v2) {
+    static_assert(tileSize % math::simd::intWidth == 0, "Raster::tileSize must fill whole simd registers");
+    constexpr int64_t one = 1 << subBits;
+    constexpr float limit = float(1 << 24);  // keeps every product below 2^63
+
+    const Vertex *vs[3] = { &v0, &v1, &v2 };
+    int64_t X[3], Y[3];
+    for (int i = 0; i < 3; i++) {
+      float x = vs[i]->p.x * float(one), y = vs[i]->p.y * float(one);
+      if (!(fabsf(x) < limit && fabsf(y) < limit))
+        return 0;
+      X[i] = int64_t(floorf(x + 0.5f));
+      Y[i] = int64_t(floorf(y + 0.5f));
+    }
+
+    // edge i faces vertex i and is positive on its side
+    int64_t a[3], b[3], c[3];
+    for (int i = 0; i < 3; i++) {
+      int j = (i + 1) % 3, k = (i + 2) % 3;
+      a[i] = Y[j] - Y[k];
+      b[i] = X[k] - X[j];
+      c[i] = X[j] * Y[k] - X[k] * Y[j];
+    }
+    int64_t area = a[0] * X[0] + b[0] * Y[0] + c[0];
+    if (!area)
+      return 0;
+    if (area < 0) {
+      for (int i = 0; i < 3; i++) {
+        a[i] = -a[i];
+        b[i] = -b[i];
+        c[i] = -c[i];
+      }
+      area = -area;
+    }
+    if (conservative) {
+      // each edge pushed out by half a texel along both axes, so every texel square the
+      // triangle touches passes it
+      for (int i = 0; i < 3; i++)
+        c[i] += (std::abs(a[i]) + std::abs(b[i])) * one / 2;
+    } else {
+      // top-left rule: inside is e >= 0 on left and top edges and e > 0 on the others
+      for (int i = 0; i < 3; i++)
+        if (!(a[i] > 0 || (a[i] == 0 && b[i] > 0)))
+          c[i] -= 1;
+    }
+
+    // values are stepped per texel and anchored at the snapped first vertex
+    std::array<float, numValues> f[3];
+    unpack(v0.values, f[0].data(), std::index_sequence_for<Ts...>());
+    unpack(v1.values, f[1].data(), std::index_sequence_for<Ts...>());
+    unpack(v2.values, f[2].data(), std::index_sequence_for<Ts...>());
+    std::array<float, numValues> dx, dy;
+    double scale = double(one) / double(area);
+    for (int k = 0; k < numValues; k++) {
+      dx[k] = float(scale * (double(a[0]) * f[0][k] + double(a[1]) * f[1][k] + double(a[2]) * f[2][k]));
+      dy[k] = float(scale * (double(b[0]) * f[0][k] + double(b[1]) * f[1][k] + double(b[2]) * f[2][k]));
+    }
+    float ax = float(X[0]) / float(one), ay = float(Y[0]) / float(one);
+
+    int64_t grow = conservative ? one / 2 : 0;
+    int x0 = int(std::max<int64_t>(clipX0, ceilDiv(std::min(X[0], std::min(X[1], X[2])) - grow, one)));
+    int x1 = int(std::min<int64_t>(clipX1, floorDiv(std::max(X[0], std::max(X[1], X[2])) + grow, one)));
+    int y0 = int(std::max<int64_t>(clipY0, ceilDiv(std::min(Y[0], std::min(Y[1], Y[2])) - grow, one)));
+    int y1 = int(std::min<int64_t>(clipY1, floorDiv(std::max(Y[0], std::max(Y[1], Y[2])) + grow, one)));
+    if (x0 > x1 || y0 > y1)
+      return 0;
+
+    int64_t stepX[3], stepY[3];
+    bool narrow = true;
+    for (int i = 0; i < 3; i++) {
+      stepX[i] = a[i] * one;
+      stepY[i] = b[i] * one;
+      narrow = narrow && std::max(std::abs(stepX[i]), std::abs(stepY[i])) < (int64_t(1) << 30) / (2 * tileSize);
+    }
+    // lane offsets of each edge along a tile row, usable when a whole tile spans less than
+    // 2^30 of the edge function, which is every tile of a sanely sized lightmap
+    alignas(32) int32_t lanes[3][tileSize];
+    for (int i = 0; i < 3; i++)
+      for (int l = 0; l < tileSize; l++)
+        lanes[i][l] = narrow ? int32_t(stepX[i] * l) : 0;
+
+    int written = 0;
+    std::array<float, numValues> values;
+    // tiles are aligned to the target, so a clip on tile boundaries cuts no tile
+    int tx0 = x0 - x0 % tileSize;
+    band.resize(size_t((x1 - tx0) / tileSize + 1));
+    for (int ty = y0 - y0 % tileSize; ty <= y1; ty += tileSize) {
+      int py0 = std::max(ty, y0), py1 = std::min(ty + tileSize - 1, y1);
+
+      // each edge over the corners of each tile in the band: all negative culls the tile,
+      // all positive drops the edge from the per texel tests
+      for (size_t t = 0; t < band.size(); t++) {
+        Tile &tile = band[t];
+        int tx = tx0 + int(t) * tileSize;
+        tile.x0 = std::max(tx, x0);
+        tile.x1 = std::min(tx + tileSize - 1, x1);
+        tile.numCrossing = 0;
+        tile.culled = false;
+        tile.wide = narrow;
+        for (int i = 0; i < 3 && !tile.culled; i++) {
+          int64_t e = a[i] * tile.x0 * one + b[i] * py0 * one + c[i];
+          int64_t ex = stepX[i] * (tile.x1 - tile.x0), ey = stepY[i] * (py1 - py0);
+          int64_t lo = e + std::min<int64_t>(0, ex) + std::min<int64_t>(0, ey);
+          int64_t hi = e + std::max<int64_t>(0, ex) + std::max<int64_t>(0, ey);
+          tile.culled = hi < 0;
+          if (lo < 0) {
+            tile.e[tile.numCrossing] = e;
+            tile.crossing[tile.numCrossing++] = i;
+            tile.wide = tile.wide && hi - lo < (int64_t(1) << 30);
+          }
+        }
+      }
+
+      // then row by row through the band, so writes stream along each layer. values start
+      // over at each tile, which keeps them independent of the clip
+      for (int y = py0; y <= py1; y++) {
+        size_t rowIndex = size_t(y) * target.w;
+        for (const Tile &tile : band) {
+          if (tile.culled)
+            continue;
+          uint32_t covered = (1u << (tile.x1 - tile.x0 + 1)) - 1u;
+          for (int n = 0; n < tile.numCrossing; n++) {
+            int i = tile.crossing[n];
+            int64_t edge = tile.e[n] + stepY[i] * (y - py0);
+            uint32_t bits = 0;
+            if (tile.wide) {
+              math::simd::Int base = int32_t(edge);
+              for (int l = 0; l < tileSize; l += math::simd::intWidth)
+                bits |= math::simd::mask(base + math::simd::Int::load(lanes[i] + l) > math::simd::Int(-1)) << l;
+            } else {
+              for (int l = 0; l <= tile.x1 - tile.x0; l++)
+                bits |= edge + stepX[i] * l >= 0 ? 1u << l : 0u;
+            }
+            covered &= bits;
+          }
+          if (!covered)
+            continue;
+          // a triangle crosses a row in one run, so the covered bits are contiguous
+          int x = tile.x0;
+          for (; !(covered & 1u); covered >>= 1)
+            x++;
+          for (int k = 0; k < numValues; k++)
+            values[k] = f[0][k] + dx[k] * (float(x) - ax) + dy[k] * (float(y) - ay);
+          for (; covered & 1u; covered >>= 1, x++) {
+            pack(values.data(), v0.values, rowIndex + size_t(x), std::index_sequence_for<Ts...>());
+            for (int k = 0; k < numValues; k++)
+              values[k] += dx[k];
+            written++;
+          }
+        }
+      }
+    }
+    return written;
+  }
+
+ protected:
+  struct Tile {
+    int x0, x1;
+    int numCrossing;
+    int crossing[3];
+    int64_t e[3];  // crossing edges at the tile's first texel
+    bool culled, wide;
+  };
+
+  Target &target;
+  int clipX0 = 0, clipY0 = 0, clipX1, clipY1;
+  std::vector<Tile> band;  // the tiles of one row of tiles, kept between draws
+
+  static constexpr std::array<int, sizeof...(Ts)> offsets() {
+    std::array<int, sizeof...(Ts)> result { };
+    int sizes[] = { Interpolant<Ts>::size... };
+    int offset = 0;
+    for (size_t i = 0; i < sizeof...(Ts); i++) {
+      result[i] = offset;
+      offset += sizes[i];
+    }
+    return result;
+  }
+  static constexpr std::array<int, sizeof...(Ts)> offset = offsets();
+
+  static int64_t floorDiv(int64_t v, int64_t d) {
+    return v >= 0 ? v / d : -((-v + d - 1) / d);
+  }
+  static int64_t ceilDiv(int64_t v, int64_t d) {
+    return -floorDiv(-v, d);
+  }
+
+  template<size_t ... Is>
+  static void unpack(const std::tuple<Ts...> &values, float *out, std::index_sequence<Is...>) {
+    (Interpolant<Ts>::unpack(std::get<Is>(values), out + offset[Is]), ...);
+  }
+
+  template<size_t ... Is>
+  void pack(const float *in, const std::tuple<Ts...> &first, size_t index, std::index_sequence<Is...>) {
+    (Interpolant<Ts>::pack(in + offset[Is], std::get<Is>(first), target.template at<Is>(index)), ...);
+  }
+};
+
+}
+}
@@ -1,23 +1,49 @@
-#pragma once
-
-#include "../math/vector.h"
-#include <string_view>
-#include "../utils/image.h"
-
-
-namespace mbz{
-namespace rasterizer{
-
-bool loadTexture(const mbz::utils::img::Image &image, std::string_view tag, int &handle);
-
-int getTextureHandle(std::string_view tag);
-
-struct Texel : public Color {
-  int textureHandle = -1;
-  int mipLevel = 0;
-  mbz::math::Vector2 uv;
-  Color sample() const;
-};
-
-}
-}
+#pragma once
+
+#include "../math/vector.h"
+#include <string_view>
+#include <cstdint>
+#include <memory>
+#include "../utils/image.h"
+
+
+namespace mbz{
+namespace rasterizer{
+
+bool loadTexture(const mbz::utils::img::Image &image, std::string_view tag, int &handle);
+// registers the image itself instead of a copy, for images owned elsewhere
+bool loadTexture(std::shared_ptr<const mbz::utils::img::Image> image, std::string_view tag, int &handle);
+
+int getTextureHandle(std::string_view tag);
+
+struct Texel : public Color {
+  int textureHandle = -1;
+  int mipLevel = 0;
+  mbz::math::Vector2 uv;
+  Color sample() const;
+};
+
+// a texel as stored in a gbuffer: the same lookup without the color or the padding
+struct PackedTexel {
+  mbz::math::Vector2 uv;
+  int16_t textureHandle = -1;
+  int16_t mipLevel = 0;
+
+  PackedTexel() = default;
+  PackedTexel(mbz::math::Vector2 uv, int textureHandle, int mipLevel = 0)
+      :
+      uv(uv),
+      textureHandle(int16_t(textureHandle)),
+      mipLevel(int16_t(mipLevel)) {
+  }
+  PackedTexel(const Texel &texel)
+      :
+      uv(texel.uv),
+      textureHandle(int16_t(texel.textureHandle)),
+      mipLevel(int16_t(texel.mipLevel)) {
+  }
+  Color sample() const;
+};
+
+}
+}
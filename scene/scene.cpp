@@ -0,0 +1,526 @@
+#include "scene.h"
+#include "../thirdparty/openfbx/ofbx.h"
+#include "../thirdparty/lodepng/lodepng.h"
+#include "../rasterizer/texture.h"
+#include "../math/bpcd/instances.h"
+#include "../utils/file.h"
+#include "../utils/hash.h"
+#include "../utils/log.h"
+#include "../utils/workers.h"
+
+#include <map>
+#include <utility>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+
+namespace mbz {
+namespace scene {
+
+namespace {
+
+// a vertex snapped to the welding lattice. vertices landing on the same key are one vertex
+struct WeldKey {
+  int32_t q[10];
+  bool operator==(const WeldKey &o) const {
+    return memcmp(q, o.q, sizeof(q)) == 0;
+  }
+};
+
+struct WeldKeyHash {
+  size_t operator()(const WeldKey &k) const {
+    return size_t(utils::heap::hasher64(utils::heap::hasher64(), k.q, sizeof(k.q)));
+  }
+};
+
+// lattice steps: positions relative to the mesh size, normals and uvs absolute
+constexpr float positionQuantum = 1.0f / float(1 << 20);
+constexpr float normalQuantum = 1.0f / float(1 << 10);
+constexpr float uvQuantum = 1.0f / float(1 << 16);
+
+int32_t quantize(float v, float step) {
+  return int32_t(std::lround(double(v) / double(step)));
+}
+
+std::mutex scenesMutex;
+std::map<std::string, std::weak_ptr<const Scene>> scenes;
+
+}
+
+std::shared_ptr<const Scene> Scene::load(std::shared_ptr<utils::heap::Heap> heap, std::string_view name, int lightmapSize) {
+  // held across the load, so callers racing for the same scene parse it once
+  std::lock_guard<std::mutex> lock(scenesMutex);
+  auto &slot = scenes[std::string(name) + ":" + std::to_string(lightmapSize)];
+  if (auto loaded = slot.lock())
+    return loaded;
+
+  auto scene = std::make_shared<Scene>();
+  scene->name = name;
+  scene->heap = heap;
+  scene->lightmapSize = lightmapSize;
+  if (!scene->loadFBX(std::string("assets/") + std::string(name) + std::string(".fbx")))
+    return nullptr;
+  slot = scene;
+  return scene;
+}
+
+bool Instance::identity() const {
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      if (linear.es[i][j] != (i == j ? 1.0f : 0.0f))
+        return false;
+  return translation.x == 0.0f && translation.y == 0.0f && translation.z == 0.0f && uvScale.x == 1.0f && uvScale.y == 1.0f && uvOffset.x == 0.0f
+      && uvOffset.y == 0.0f;
+}
+
+Vertex Instance::toWorld(const Vertex &v) const {
+  Vertex world = v;
+  world.p = linear * v.p + translation;
+  world.n = (normals * v.n).normalized();
+  world.uv1 = math::Vector2(v.uv1.x * uvScale.x + uvOffset.x, v.uv1.y * uvScale.y + uvOffset.y);
+  return world;
+}
+
+math::bpcd::TriangleView Mesh::trianglePoints() const {
+  if (triangles.empty())
+    return math::bpcd::TriangleView(nullptr, sizeof(Vertex), nullptr, 4, 0);
+  return math::bpcd::TriangleView(&vertices[0].p, sizeof(Vertex), triangles[0].data(), 4, triangles.size());
+}
+
+namespace {
+
+void loadMesh(Mesh &mesh, const ofbx::GeometryData &geom, const std::vector<int> &materials) {
+  auto positions = geom.getPositions();
+  auto normals = geom.getNormals();
+  auto uv1s = geom.getUVs(0);
+  auto uv2s = geom.getUVs(1);
+
+  // welding: corners whose attributes agree to within the lattice steps share a vertex,
+  // the first one seen keeps its exact values
+  math::Vector3 minExt(1e30f, 1e30f, 1e30f), maxExt(-1e30f, -1e30f, -1e30f);
+  for (int i = 0; i < positions.count; i++) {
+    auto p = positions.get(i);
+    math::Vector3 v(p.x, p.y, p.z);
+    for (int j = 0; j < 3; j++) {
+      minExt.xyz[j] = std::min(minExt.xyz[j], v.xyz[j]);
+      maxExt.xyz[j] = std::max(maxExt.xyz[j], v.xyz[j]);
+    }
+  }
+  float extent = 0.0f;
+  for (int j = 0; j < 3; j++)
+    extent = std::max(extent, maxExt.xyz[j] - minExt.xyz[j]);
+  float positionStep = extent > 0.0f ? extent * positionQuantum : positionQuantum;
+
+  std::unordered_map<WeldKey, int, WeldKeyHash> indices;
+  indices.reserve(size_t(positions.count));
+  auto push_vertex = [&](int index) {
+    auto p = positions.get(index);
+    auto n = normals.get(index);
+    auto uv1 = uv1s.get(index);
+    auto uv2 = uv2s.get(index);
+    Vertex vert;
+    vert.p = math::Vector3(p.x, p.y, p.z);
+    vert.n = math::Vector3(n.x, n.y, n.z);
+    vert.uv1 = math::Vector2(uv1.x, uv1.y);
+    vert.uv2 = math::Vector2(uv2.x, uv2.y);
+    WeldKey key;
+    for (int j = 0; j < 3; j++) {
+      key.q[j] = quantize(vert.p.xyz[j], positionStep);
+      key.q[3 + j] = quantize(vert.n.xyz[j], normalQuantum);
+    }
+    key.q[6] = quantize(vert.uv1.x, uvQuantum);
+    key.q[7] = quantize(vert.uv1.y, uvQuantum);
+    key.q[8] = quantize(vert.uv2.x, uvQuantum);
+    key.q[9] = quantize(vert.uv2.y, uvQuantum);
+    auto found = indices.emplace(key, int(mesh.vertices.size()));
+    if (found.second)
+      mesh.vertices.push_back(vert);
+    return found.first->second;
+  };
+
+  int corners = 0;
+  for (int i = 0; i < geom.getPartitionCount(); i++) {
+    const auto &par = geom.getPartition(i);
+    int material = materials[std::min(i, int(materials.size()) - 1)];
+    for (int j = 0; j < par.polygon_count; j++) {
+      auto poly = par.polygons[j];
+      int a = push_vertex(poly.from_vertex + 0);
+      int b = push_vertex(poly.from_vertex + 1);
+      int c = push_vertex(poly.from_vertex + 2);
+      corners += 3;
+      if (a == b || b == c || c == a)
+        continue;  // welded flat, nothing to trace or raster
+      mesh.triangles.push_back( { a, b, c, material });
+    }
+  }
+  LOGINFO("loadMesh()", "'%s': %d corners welded to %zu vertices, %zu triangles, %zu bytes indexed vs %zu unindexed", mesh.name.c_str(), corners,
+          mesh.vertices.size(), mesh.triangles.size(), mesh.vertices.size() * sizeof(Vertex) + mesh.triangles.size() * sizeof(mesh.triangles[0]),
+          mesh.triangles.size() * 3 * sizeof(Vertex));
+}
+
+// a png with its mips, null when it doesn't load
+std::shared_ptr<const utils::img::Image> decodeTexture(const std::string &file) {
+  utils::FileData data(file);
+  if (data.empty()) {
+    LOGERROR("decodeTexture()", "'%s' not found", file.c_str());
+    return nullptr;
+  }
+  uint32_t w, h;
+  std::vector<uint8_t> pixels;
+  auto error = lodepng::decode(pixels, w, h, data.data(), data.size());
+  if (error) {
+    LOGERROR("decodeTexture()", "'%s' PNG load failed: %s", file.c_str(), lodepng_error_text(error));
+    return nullptr;
+  }
+  LOGINFO("decodeTexture()", "'%s' texture size %d x %d", file.c_str(), w, h);
+  auto image = std::make_shared<utils::img::Image>();
+  image->fromRGBA(pixels.data(), int(w), int(h));
+  return image;
+}
+
+// texels kept clear around every packed chart, so neighbours are twice that apart and a
+// dilation of up to this many texels stays inside
+constexpr int packMargin = 2;
+
+// the lightmap uvs of an instance's mesh: their bounds, and their area alongside the world
+// space area the instance gives them
+struct Chart {
+  math::Vector2 minUv, maxUv;
+  double uvArea = 0.0, area = 0.0;
+};
+
+// whether the authored layout already has every instance in a region of [0, 1] of its own
+bool disjoint(const std::vector<Chart> &charts) {
+  for (size_t i = 0; i < charts.size(); i++) {
+    const Chart &a = charts[i];
+    if (a.minUv.x < 0.0f || a.minUv.y < 0.0f || a.maxUv.x > 1.0f || a.maxUv.y > 1.0f)
+      return false;
+    for (size_t j = 0; j < i; j++) {
+      const Chart &b = charts[j];
+      if (a.minUv.x < b.maxUv.x && b.minUv.x < a.maxUv.x && a.minUv.y < b.maxUv.y && b.minUv.y < a.maxUv.y)
+        return false;
+    }
+  }
+  return true;
+}
+
+// packs the charts into shelves of the unit square, sides scaled by the instances' own
+// scale times k, tallest first. false when they do not fit
+bool shelve(const std::vector<Chart> &charts, const std::vector<double> &scales, const std::vector<int> &order, double k, double margin,
+            std::vector<math::Vector2> *corners = nullptr) {
+  double x = 0.0, y = 0.0, shelf = 0.0;
+  for (int i : order) {
+    double w = (charts[i].maxUv.x - charts[i].minUv.x) * scales[i] * k + 2.0 * margin;
+    double h = (charts[i].maxUv.y - charts[i].minUv.y) * scales[i] * k + 2.0 * margin;
+    if (x + w > 1.0) {
+      x = 0.0;
+      y += shelf;
+      shelf = 0.0;
+    }
+    if (w > 1.0 || y + h > 1.0)
+      return false;
+    if (corners)
+      (*corners)[i] = math::Vector2(float(x + margin), float(y + margin));
+    x += w;
+    shelf = std::max(shelf, h);
+  }
+  return true;
+}
+
+// instances of one mesh and separately unwrapped meshes all lay their lightmap uvs over
+// the same [0, 1] range, so unless the authored layout already keeps the instances apart
+// each gets a chart of its own. charts are scaled for the same texel density in world
+// space and shelf packed as large as they fit into a lightmap of lightmapSize texels, with
+// packMargin texels around each. a lone instance keeps its uvs as they are
+void packLightmap(std::vector<Instance> &instances, const std::vector<Mesh> &meshes, int lightmapSize) {
+  if (instances.size() < 2)
+    return;
+  std::vector<Chart> charts(instances.size());
+  for (size_t i = 0; i < instances.size(); i++) {
+    const Instance &instance = instances[i];
+    const Mesh &mesh = meshes[instance.mesh];
+    Chart &chart = charts[i];
+    chart.minUv = math::Vector2(1e30f, 1e30f);
+    chart.maxUv = math::Vector2(-1e30f, -1e30f);
+    for (const Vertex &vert : mesh.vertices) {
+      chart.minUv = math::Vector2(std::min(chart.minUv.x, vert.uv1.x), std::min(chart.minUv.y, vert.uv1.y));
+      chart.maxUv = math::Vector2(std::max(chart.maxUv.x, vert.uv1.x), std::max(chart.maxUv.y, vert.uv1.y));
+    }
+    for (const auto &tri : mesh.triangles) {
+      const Vertex &v0 = mesh.vertices[tri[0]], &v1 = mesh.vertices[tri[1]], &v2 = mesh.vertices[tri[2]];
+      math::Vector3 u = instance.linear * (v1.p - v0.p), v = instance.linear * (v2.p - v0.p);
+      chart.area += 0.5 * double(u.cross(v).length());
+      math::Vector2 s = v0.uv1.point(v1.uv1), t = v0.uv1.point(v2.uv1);
+      chart.uvArea += 0.5 * std::abs(double(s.x) * t.y - double(t.x) * s.y);
+    }
+  }
+  if (disjoint(charts)) {
+    LOGINFO("packLightmap()", "%zu instances keep their authored lightmap uvs", instances.size());
+    return;
+  }
+
+  // one scale on both axes, so texels stay square, making world area per uv area the same
+  // for every chart
+  std::vector<double> scales(charts.size());
+  double hi = 1e30;
+  double margin = double(packMargin) / double(std::max(1, lightmapSize));
+  for (size_t i = 0; i < charts.size(); i++) {
+    const Chart &chart = charts[i];
+    double extent = std::max(chart.maxUv.x - chart.minUv.x, chart.maxUv.y - chart.minUv.y);
+    double area = std::max(chart.area, 1e-12);
+    scales[i] = chart.uvArea > 0.0 ? std::sqrt(area / chart.uvArea) : std::sqrt(area) / std::max(extent, 1e-6);
+    if (extent > 0.0)
+      hi = std::min(hi, (1.0 - 2.0 * margin) / (extent * scales[i]));
+  }
+  std::vector<int> order(charts.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = int(i);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return (charts[a].maxUv.y - charts[a].minUv.y) * scales[a] > (charts[b].maxUv.y - charts[b].minUv.y) * scales[b];
+  });
+  // the largest common scale that still fits
+  double lo = 0.0;
+  if (hi >= 1e30)
+    hi = 1.0;
+  if (!shelve(charts, scales, order, lo, margin)) {
+    LOGWARN("packLightmap()", "%zu instances leave no room for %d texel margins in a %d lightmap", instances.size(), packMargin, lightmapSize);
+    margin = 0.0;
+  }
+  for (int step = 0; step < 40; step++) {
+    double k = 0.5 * (lo + hi);
+    if (shelve(charts, scales, order, k, margin))
+      lo = k;
+    else
+      hi = k;
+  }
+  std::vector<math::Vector2> corners(charts.size());
+  shelve(charts, scales, order, lo, margin, &corners);
+  for (size_t i = 0; i < instances.size(); i++) {
+    float scale = float(scales[i] * lo);
+    instances[i].uvScale = math::Vector2(scale, scale);
+    instances[i].uvOffset = math::Vector2(corners[i].x - charts[i].minUv.x * scale, corners[i].y - charts[i].minUv.y * scale);
+  }
+  LOGINFO("packLightmap()", "%zu instances packed into the lightmap with %d texel margins at %d", instances.size(), packMargin, lightmapSize);
+}
+
+// global transform of an fbx mesh in meters. fbx units are centimeters times the file's
+// unit scale factor, and its matrices are column major
+void placeInstance(Instance &instance, const ofbx::Mesh &mesh, double toMeters) {
+  ofbx::DMatrix global = mesh.getGlobalTransform(), geometric = mesh.getGeometricMatrix(), m;
+  for (int c = 0; c < 4; c++)
+    for (int r = 0; r < 4; r++) {
+      m.m[c * 4 + r] = 0.0;
+      for (int k = 0; k < 4; k++)
+        m.m[c * 4 + r] += global.m[k * 4 + r] * geometric.m[c * 4 + k];
+    }
+  bool identity = true;
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      double e = m.m[c * 4 + r] * toMeters;
+      identity = identity && std::abs(e - (r == c ? 1.0 : 0.0)) < 1e-6;
+      instance.linear.es[r][c] = float(e);
+    }
+    double t = m.m[12 + r] * toMeters;
+    identity = identity && std::abs(t) < 1e-6;
+    instance.translation.xyz[r] = float(t);
+  }
+  if (identity) {
+    // snapped, so untransformed meshes keep their exact vertices
+    instance.linear.identity();
+    instance.translation = math::Vector3();
+  }
+  instance.normals = math::Matrix3(instance.linear.inverted().transposed());
+}
+
+}
+
+bool Scene::loadFBX(std::string_view fileName) {
+  ofbx::LoadFlags f =
+  //    ofbx::LoadFlags::IGNORE_MODELS |
+      ofbx::LoadFlags::IGNORE_BLEND_SHAPES | ofbx::LoadFlags::IGNORE_CAMERAS | ofbx::LoadFlags::IGNORE_LIGHTS |
+      //    ofbx::LoadFlags::IGNORE_TEXTURES |
+          ofbx::LoadFlags::IGNORE_SKIN | ofbx::LoadFlags::IGNORE_BONES | ofbx::LoadFlags::IGNORE_PIVOTS |
+          //    ofbx::LoadFlags::IGNORE_MATERIALS |
+          ofbx::LoadFlags::IGNORE_POSES | ofbx::LoadFlags::IGNORE_VIDEOS | ofbx::LoadFlags::IGNORE_LIMBS |
+          //    ofbx::LoadFlags::IGNORE_MESHES |
+          ofbx::LoadFlags::IGNORE_ANIMATIONS;
+
+  // ofbx parses from its own copy of the bytes, so the mapping goes as soon as it is read
+  // and the parsed scene as soon as the meshes are out of it
+  std::unique_ptr<ofbx::IScene, void (*)(ofbx::IScene*)> fbx(nullptr, [](ofbx::IScene *scene) {
+    scene->destroy();
+  });
+  {
+    utils::FileData data(fileName);
+    fbx.reset(ofbx::load(data.data(), data.size(), ofbx::u16(f)));
+  }
+  if (!fbx || !fbx->getMeshCount()) {
+    LOGERROR("Scene::loadFBX()", "'%s' has no mesh", std::string(fileName).c_str());
+    return false;
+  }
+  const ofbx::GlobalSettings *settings = fbx->getGlobalSettings();
+  double toMeters = (settings ? double(settings->UnitScaleFactor) : 1.0) / 100.0;
+
+  // fbx meshes are instances of their geometry, so there is one Mesh per geometry and
+  // material list
+  std::map<std::pair<const ofbx::Geometry*, std::vector<int>>, int> unique;
+  for (int m = 0; m < fbx->getMeshCount(); m++) {
+    const ofbx::Mesh *fbxMesh = fbx->getMesh(m);
+    const ofbx::Geometry *geometry = fbxMesh->getGeometry();
+    if (!geometry)
+      continue;
+    std::vector<int> meshMaterials;
+    for (int i = 0; i < fbxMesh->getMaterialCount(); i++)
+      meshMaterials.push_back(addMaterial(fbxMesh->getMaterial(i)->name));
+    if (meshMaterials.empty())
+      meshMaterials.push_back(addMaterial(""));
+
+    auto found = unique.emplace(std::make_pair(geometry, meshMaterials), int(meshes.size()));
+    if (found.second) {
+      meshes.emplace_back();
+      meshes.back().name = fbxMesh->name;
+      loadMesh(meshes.back(), geometry->getGeometryData(), meshMaterials);
+      if (meshes.back().triangles.empty()) {
+        // nothing to trace or raster, so neither the mesh nor any instance of it is kept
+        LOGWARN("Scene::loadFBX()", "'%s' has no triangles, skipped", fbxMesh->name);
+        meshes.pop_back();
+        found.first->second = -1;
+      }
+    }
+    if (found.first->second < 0)
+      continue;
+
+    Instance instance;
+    instance.mesh = found.first->second;
+    placeInstance(instance, *fbxMesh, toMeters);
+    instance.firstTriangle = numTriangles;
+    numTriangles += int(meshes[instance.mesh].triangles.size());
+    instances.push_back(instance);
+  }
+  if (!numTriangles) {
+    LOGERROR("Scene::loadFBX()", "'%s' has no triangles", std::string(fileName).c_str());
+    return false;
+  }
+  packLightmap(instances, meshes, lightmapSize);
+  loadTextures();
+
+  math::Vector3 minExt(1e30f, 1e30f, 1e30f), maxExt(-1e30f, -1e30f, -1e30f);
+  for (const Instance &instance : instances) {
+    bool identity = instance.identity();
+    for (const Vertex &vert : meshes[instance.mesh].vertices) {
+      math::Vector3 p = identity ? vert.p : math::Vector3(instance.linear * vert.p + instance.translation);
+      for (int j = 0; j < 3; j++) {
+        minExt.xyz[j] = std::min(minExt.xyz[j], p.xyz[j]);
+        maxExt.xyz[j] = std::max(maxExt.xyz[j], p.xyz[j]);
+      }
+    }
+  }
+  bounds.fromExtents(minExt, maxExt);
+  size_t numVertices = 0;
+  for (const Mesh &mesh : meshes)
+    numVertices += mesh.vertices.size();
+  LOGINFO("Scene::loadFBX()", "'%s': %zu instances of %zu meshes, %d triangles placed, %zu vertices stored, %zu materials", std::string(fileName).c_str(),
+          instances.size(), meshes.size(), numTriangles, numVertices, materials.size());
+  return true;
+}
+
+int Scene::addMaterial(std::string_view materialName) {
+  for (size_t i = 0; i < materials.size(); i++)
+    if (materials[i].name == materialName)
+      return int(i);
+  materials.emplace_back();
+  materials.back().name = materialName;
+  return int(materials.size() - 1);
+}
+
+void Scene::loadTextures() {
+  // decoded and mipped on the pool, one texture per task, then handed to the rasterizer in
+  // material order since its texture table isn't shared between threads
+  struct DecodeTask : public utils::multithread::Task {
+    std::string file;
+    std::shared_ptr<const utils::img::Image> *image;
+    virtual void perform(utils::multithread::Toolbox *toolbox) override {
+      *image = decodeTexture(file);
+    }
+  };
+  std::vector<std::shared_ptr<const utils::img::Image>> images(materials.size());
+  utils::multithread::Workers workers(heap, uint32_t(materials.size()));
+  for (size_t i = 0; i < materials.size(); i++) {
+    if (materials[i].name.empty())
+      continue;  // stands in for meshes without materials
+    auto task = std::make_unique<DecodeTask>();
+    task->file = "assets/" + materials[i].name + ".png";
+    task->image = &images[i];
+    workers.todo.append_move(std::move(task));
+  }
+  uint64_t t0 = getCounter();
+  workers.beginJoin();
+  LOGINFO("Scene::loadTextures()", "%d textures decoded in %.3fs", workers.completed.size, double(getCounter() - t0) / double(getFreq()));
+  for (size_t i = 0; i < materials.size(); i++) {
+    materials[i].image = images[i];
+    if (images[i])
+      rasterizer::loadTexture(materials[i].image, materials[i].name, materials[i].texture);
+  }
+}
+
+std::shared_ptr<math::bpcd::Tracer> Scene::tracer(math::bpcd::TracerType type, float cellScale) const {
+  std::lock_guard<std::mutex> lock(tracersMutex);
+  if (type == math::bpcd::TracerType::Bvh || cellScale < 0.0f)
+    cellScale = 0.0f;  // bvhs have no cells
+  auto same = [&](const BuiltTracer &built) {
+    return built.type == type && built.cellScale == cellScale;
+  };
+  auto found = std::find_if(tracers.begin(), tracers.end(), same);
+  if (found != tracers.end())
+    return found->tracer;
+  // meshes placed mirrored somewhere also get a tracer of their triangles wound the other
+  // way, cached under their own key
+  std::vector<bool> mirrored(meshes.size(), false);
+  for (const Instance &instance : instances)
+    if (instance.linear.determinant() < 0.0f)
+      mirrored[instance.mesh] = true;
+  std::vector<std::shared_ptr<math::bpcd::Tracer>> blases, mirroredBlases(meshes.size());
+  for (size_t i = 0; i < meshes.size(); i++) {
+    // the blas is built in the mesh's own units, whatever scale its instances place it at
+    std::optional<math::Vector3> cellSize;
+    if (cellScale > 0.0f) {
+      math::Vector3 lo = meshes[i].vertices[0].p, hi = lo;
+      for (const Vertex &v : meshes[i].vertices)
+        for (int k = 0; k < 3; k++) {
+          lo.xyz[k] = std::min(lo.xyz[k], v.p.xyz[k]);
+          hi.xyz[k] = std::max(hi.xyz[k], v.p.xyz[k]);
+        }
+      math::Vector3 size = cellScale * (hi - lo);
+      float length = std::max((size.x + size.y + size.z) / 3.0f, 1e-6f);
+      LOGINFO("Scene::tracer", "'%s' cell size: %f", meshes[i].name.c_str(), length);
+      cellSize = math::Vector3(length, length, length);
+    }
+    std::string cachePrefix = "assets/" + name + (i ? "." + std::to_string(i) : std::string());
+    blases.push_back(math::bpcd::createTracer(type, heap, meshes[i].trianglePoints(), cellSize, cachePrefix));
+    if (mirrored[i])
+      mirroredBlases[i] = math::bpcd::createTracer(type, heap, meshes[i].trianglePoints().flipped(), cellSize, cachePrefix);
+  }
+  std::shared_ptr<math::bpcd::Tracer> built;
+  if (instances.size() == 1 && instances[0].identity()) {
+    built = blases[instances[0].mesh];
+  } else {
+    std::vector<math::bpcd::Instance> placed;
+    for (const Instance &instance : instances) {
+      math::bpcd::Instance p;
+      p.blas = blases[instance.mesh];
+      p.mirroredBlas = mirroredBlases[instance.mesh];
+      p.linear = instance.linear;
+      p.translation = instance.translation;
+      p.firstIndex = instance.firstTriangle;
+      placed.push_back(p);
+    }
+    built = std::make_shared<math::bpcd::InstanceBvh>(std::move(placed));
+  }
+  tracers.push_back( { type, cellScale, built });
+  return built;
+}
+
+}
+}
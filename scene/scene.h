@@ -0,0 +1,129 @@
+#pragma once
+
+#include "../math/vector.h"
+#include "../math/geometry.h"
+#include "../math/bpcd/tracer.h"
+#include "../utils/heap.h"
+#include "../utils/image.h"
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+
+namespace mbz {
+namespace scene {
+
+struct Vertex {
+  math::Vector3 p;
+  math::Vector3 n;
+  math::Vector2 uv1;  // lightmap
+  math::Vector2 uv2;  // material
+};
+
+struct Material {
+  std::string name;
+  int texture = -1;  // rasterizer texture handle, -1 when the png failed to load
+  std::shared_ptr<const utils::img::Image> image = nullptr;  // mips included
+};
+
+// unique geometry in object space, stored once however many instances place it. vertices
+// are welded on load, corners agreeing in every attribute to within a small lattice step
+// being one vertex. triangles hold three vertex indices and a scene material index, the one
+// index buffer the tracers, the rasterizer and the viewer all read
+struct Mesh {
+  std::string name;
+  std::vector<Vertex> vertices;
+  std::vector<std::array<int, 4>> triangles;
+
+  // triangle corners read in place through the index buffer, what the tracers are built
+  // from. valid while the mesh is
+  math::bpcd::TriangleView trianglePoints() const;
+};
+
+// a mesh placed in the world. its lightmap uvs are the mesh's scaled and offset, into a
+// chart of the lightmap of its own when the scene's authored layout overlaps
+struct Instance {
+  int mesh = 0;
+  math::Matrix3 linear;  // object to world, translation aside
+  math::Matrix3 normals;  // inverse transpose of linear
+  math::Vector3 translation;
+  math::Vector2 uvScale = math::Vector2(1.0f, 1.0f);
+  math::Vector2 uvOffset;
+  int firstTriangle = 0;  // scene wide index of the instance's first triangle
+
+  Instance() {
+    linear.identity();
+    normals.identity();
+  }
+
+  bool identity() const;
+  Vertex toWorld(const Vertex &v) const;
+};
+
+// geometry, materials and ray tracers of one fbx, read-only once loaded. load() parses the
+// file and decodes its textures once per name, so the builder, every solver and the viewer
+// share the same copy. every mesh of the file becomes an instance, and fbx meshes sharing
+// geometry and materials share one Mesh. world units are meters
+class Scene {
+ public:
+  std::string name;
+  std::shared_ptr<utils::heap::Heap> heap = nullptr;
+  std::vector<Mesh> meshes;
+  std::vector<Instance> instances;
+  std::vector<Material> materials;
+  math::Aabb bounds;
+  int numTriangles = 0;  // over all instances
+  int lightmapSize = 512;  // see load()
+
+  // the scene loaded from assets/<name>.fbx, shared with every other caller asking for the
+  // same lightmap size while anyone holds it. lightmapSize is the side in texels of the
+  // lightmap the instances are packed for. null when the file has no mesh
+  static std::shared_ptr<const Scene> load(std::shared_ptr<utils::heap::Heap> heap, std::string_view name, int lightmapSize = 512);
+
+  // calls f(index, vertices, material) for every triangle of every instance, vertices in
+  // world space and index being the scene wide triangle index tracers report
+  template<typename F>
+  void forEachTriangle(F f) const {
+    for (const Instance &instance : instances) {
+      const Mesh &mesh = meshes[instance.mesh];
+      bool identity = instance.identity();
+      for (size_t i = 0; i < mesh.triangles.size(); i++) {
+        const auto &tri = mesh.triangles[i];
+        Vertex vs[3];
+        for (int j = 0; j < 3; j++)
+          vs[j] = identity ? mesh.vertices[tri[j]] : instance.toWorld(mesh.vertices[tri[j]]);
+        f(instance.firstTriangle + int(i), vs, tri[3]);
+      }
+    }
+  }
+
+  // built on first use and shared after that, one per type and cell scale. each mesh gets a
+  // bottom level tracer in object space, grids cached under the prefix assets/<name> for the
+  // first mesh and assets/<name>.<mesh> for the others, and an InstanceBvh places them. a
+  // scene of one untransformed instance gets its mesh's tracer directly. cellScale sizes a
+  // mesh's grid cells as a fraction of its own object space extent, 0 leaves them to
+  // Grid::autoCellSize
+  std::shared_ptr<math::bpcd::Tracer> tracer(math::bpcd::TracerType type = math::bpcd::TracerType::Grid, float cellScale = 0.0f) const;
+
+ private:
+  struct BuiltTracer {
+    math::bpcd::TracerType type;
+    float cellScale;
+    std::shared_ptr<math::bpcd::Tracer> tracer;
+  };
+  mutable std::mutex tracersMutex;
+  mutable std::vector<BuiltTracer> tracers;
+
+  bool loadFBX(std::string_view fileName);
+  // index of the material, added without its texture the first time the name comes up
+  int addMaterial(std::string_view materialName);
+  // decodes the textures of every material at once
+  void loadTextures();
+};
+
+}
+}
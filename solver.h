@@ -1,193 +1,234 @@
-#pragma once
-
-#include "math/vector.h"
-#include "math/noise.h"
-#include "math/bpcd/grid.h"
-#include "utils/workers.h"
-#include "utils/image.h"
-#include "solvers/lightmap.h"
-#include "thirdparty/mtwister/mtwister.h"
-
-#include <array>
-#include <vector>
-#include <string_view>
-#include <memory>
-
-namespace mbz {
-
-constexpr int numWorkers = 14;
-class AOSolver : public utils::multithread::Workers<numWorkers> {
- public:
-  struct Vertex {
-    math::Vector3 p;
-    math::Vector3 n;
-    math::Vector2 uv1;
-    math::Vector2 uv2;
-  };
-
-  std::shared_ptr<utils::heap::Heap> heap = nullptr;
-  std::shared_ptr<math::bpcd::Grid> grid = nullptr;
-  std::vector<int> textures;
-  std::shared_ptr<rasterizer::Canvas> canvas = nullptr;
-  std::shared_ptr<rasterizer::Scanner> scanner = nullptr;
-
-  utils::heap::Array<Vertex> vertices;
-  utils::heap::Array<std::array<int, 4>> triangles;
-  utils::img::Image result;
-
-  uint32_t seed = 345;
-  struct Task : public utils::multithread::Task {
-   public:
-    int x, y;
-    std::shared_ptr<const math::bpcd::Grid> grid;
-    math::Vector3 p;
-    math::Vector3 n;
-    math::Vector3 result;
-    virtual void perform(utils::multithread::Toolbox *toolbox) override;
-  };
-
-  struct Toolbox : public utils::multithread::Toolbox{
-    MTRandWrapper mtRand;
-    Toolbox(uint32_t seed){
-      mtRand.seed(seed);
-    }
-    Vector3 randomPointOnSphere(){
-      return math::mc::randomPointOnSphere(mtRand);
-    }
-  };
-
-  virtual std::unique_ptr<utils::multithread::Toolbox> divyToolbox(int workerId) override {
-    seed += seed;
-    return std::make_unique<Toolbox>(seed);
-  }
-
-  AOSolver(std::shared_ptr<utils::heap::Heap> heap)
-      :
-      utils::multithread::Workers<numWorkers>(heap, 512 * 512, 4096),
-      heap(heap),
-      vertices(heap, 12),
-      triangles(heap, 4) {
-  }
-  ~AOSolver() {
-    if (vertices.size)
-      vertices.release();
-    if (triangles.size)
-      triangles.release();
-  }
-  bool create(std::string_view fbxName, uint32_t rasterWidth, uint32_t rasterHeight);
-  void save();
-};
-
-class LightSolver : public utils::multithread::Workers<numWorkers> {
- public:
-  struct Vertex {
-    math::Vector3 p;
-    math::Vector3 n;
-    math::Vector2 uv1;
-    math::Vector2 uv2;
-  };
-
-  struct Lighting{
-    struct Direct{
-      Color color;
-      float intensity;
-      Vector3 direction;
-      float radius;
-    };
-
-    struct Point{
-      Sphere sphere;
-      Color color;
-      float intensity;
-    };
-
-    struct Area{
-      Color color;
-      Rect rect;
-      float intensity;
-    };
-
-    struct Cone{
-      Vector3 origin;
-      Vector3 direction;
-      float angle; //in degrees
-      float intensity;
-    };
-
-    struct Dome{
-      float angle;  //in degrees
-      Vector3 direction;
-      Color color;
-      float intensity;
-    };
-
-    std::vector<Dome> domeLights;
-    std::vector<Direct> directLights;
-    std::vector<Point> pointLights;
-    std::vector<Area> areaLights;
-
-	  Color skyColor;
-	  Color sunColor;
-	  Vector3 sunDirection;
-	  //TODO: add additional point/area lights
-  };
-
-  std::shared_ptr<utils::heap::Heap> heap = nullptr;
-  std::shared_ptr<math::bpcd::Grid> grid = nullptr;
-  std::vector<int> textures;
-  std::shared_ptr<rasterizer::Canvas> canvas = nullptr;
-  std::shared_ptr<rasterizer::Scanner> scanner = nullptr;
-
-  utils::heap::Array<Vertex> vertices;
-  utils::heap::Array<std::array<int, 4>> triangles;
-  utils::img::Image result;
-  uint32_t seed = 345;
-
-  struct Task : public utils::multithread::Task {
-   public:
-    int x, y;
-    Lighting lighting;
-
-    std::shared_ptr<const math::bpcd::Grid> grid;
-    math::Vector3 p;
-    math::Vector3 n;
-    Color c;
-    math::Vector3 result;
-    virtual void perform(utils::multithread::Toolbox *toolbox) override;
-  };
-
-  struct Toolbox : public utils::multithread::Toolbox{
-    MTRandWrapper mtRand;
-    Toolbox(uint32_t seed){
-      mtRand.seed(seed);
-    }
-    Vector3 randomPointOnSphere(){
-      return math::mc::randomPointOnSphere(mtRand);
-    }
-  };
-
-  virtual std::unique_ptr<utils::multithread::Toolbox> divyToolbox(int workerId) override {
-    seed += seed;
-    return std::make_unique<Toolbox>(seed);
-  }
-
-
-  LightSolver(std::shared_ptr<utils::heap::Heap> heap)
-      :
-      utils::multithread::Workers<numWorkers>(heap, 512 * 512, 4096),
-      heap(heap),
-      vertices(heap, 12),
-      triangles(heap, 4) {
-  }
-  ~LightSolver() {
-    if (vertices.size)
-      vertices.release();
-    if (triangles.size)
-      triangles.release();
-  }
-  bool create(std::string_view fbxName, uint32_t rasterWidth, uint32_t rasterHeight, Lighting lighting);
-  void save();
-};
-
-}
-
+#pragma once
+
+#include "math/vector.h"
+#include "math/noise.h"
+#include "math/bpcd/grid.h"
+#include "math/bpcd/tracer.h"
+#include "utils/workers.h"
+#include "utils/image.h"
+#include "rasterizer/rasterizer.h"
+#include "solvers/lightmap.h"
+#include "solvers/irradiance.h"
+#include "scene/scene.h"
+#include "math/sampler.h"
+#include "thirdparty/mtwister/mtwister.h"
+
+#include <array>
+#include <optional>
+#include <vector>
+#include <mutex>
+#include <utility>
+#include <string_view>
+#include <memory>
+
+namespace mbz {
+
+// random directions for the legacy solvers. every worker owns a mersenne twister, so
+// which texel gets which numbers depends on scheduling. a keyed toolbox instead restarts a
+// pcg stream per texel from key(), making the bake the same for any thread count
+struct SolverToolbox : public utils::multithread::Toolbox {
+  MTRandWrapper mtRand;
+  std::optional<uint32_t> keySeed;
+  math::sampling::Pcg32 rng;
+
+  SolverToolbox(uint32_t seed, std::optional<uint32_t> keySeed_ = std::nullopt)
+      :
+      keySeed(keySeed_) {
+    mtRand.seed(seed);
+  }
+
+  void key(int x, int y) {
+    if (keySeed)
+      rng.seed(*keySeed, (uint64_t(uint32_t(y)) << 32) | uint32_t(x));
+  }
+
+  Vector3 randomPointOnSphere() {
+    if (keySeed)
+      return math::sampling::uniformSphere(Vector2(rng.uniform(), rng.uniform()));
+    return math::mc::randomPointOnSphere(mtRand);
+  }
+};
+
+class AOSolver : public utils::multithread::Workers {
+ public:
+  std::shared_ptr<utils::heap::Heap> heap = nullptr;
+  std::shared_ptr<const scene::Scene> scene = nullptr;
+  std::shared_ptr<math::bpcd::Tracer> tracer = nullptr;
+  std::shared_ptr<rasterizer::Canvas> canvas = nullptr;
+  std::shared_ptr<rasterizer::Scanner> scanner = nullptr;
+
+  utils::img::Image result;
+
+  uint32_t seed = 345;  // base of the per worker seeds
+  bool deterministic = false;  // see SolverToolbox::key()
+  uint32_t deterministicSeed = 345;
+  struct Task : public utils::multithread::Task {
+   public:
+    int x, y;
+    std::shared_ptr<const math::bpcd::Tracer> tracer;
+    math::Vector3 p;
+    math::Vector3 n;
+    math::Vector3 result;
+    virtual void perform(utils::multithread::Toolbox *toolbox) override;
+  };
+
+  // tiled mode: one task shades a tileSize x tileSize block straight into result
+  static constexpr int tileSize = 16;
+  bool tiled = true;
+  struct Tile : public utils::multithread::Task {
+    AOSolver *solver = nullptr;
+    int x0, y0, x1, y1;
+    virtual void perform(utils::multithread::Toolbox *toolbox) override;
+  };
+
+  using Toolbox = SolverToolbox;
+
+  static math::Vector3 occlusion(const math::bpcd::Tracer &tracer, math::Vector3 p, math::Vector3 n, Toolbox *tools);
+
+  // called on every pool thread at once, so each worker's stream comes from its id alone
+  virtual std::unique_ptr<utils::multithread::Toolbox> divyToolbox(int workerId) override {
+    uint32_t workerSeed = math::sampling::pcgHash(seed ^ uint32_t(workerId));
+    return std::make_unique<Toolbox>(workerSeed, deterministic ? std::optional<uint32_t>(deterministicSeed) : std::nullopt);
+  }
+
+  AOSolver(std::shared_ptr<utils::heap::Heap> heap)
+      :
+      utils::multithread::Workers(heap, 512 * 512, 4096),
+      heap(heap) {
+  }
+  bool create(std::string_view fbxName, uint32_t rasterWidth, uint32_t rasterHeight, math::bpcd::TracerType tracerType = math::bpcd::TracerType::Grid);
+  bool create(std::shared_ptr<const scene::Scene> scene, uint32_t rasterWidth, uint32_t rasterHeight, math::bpcd::TracerType tracerType = math::bpcd::TracerType::Grid);
+  void save();
+};
+
+class LightSolver : public utils::multithread::Workers {
+ public:
+  struct Lighting{
+    struct Direct{
+      Color color;
+      float intensity;
+      Vector3 direction;
+      float radius;
+    };
+
+    struct Point{
+      Sphere sphere;
+      Color color;
+      float intensity;
+    };
+
+    struct Area{
+      Color color;
+      Rect rect;
+      float intensity;
+    };
+
+    struct Cone{
+      Vector3 origin;
+      Vector3 direction;
+      float angle; //in degrees
+      float intensity;
+    };
+
+    struct Dome{
+      float angle;  //in degrees
+      Vector3 direction;
+      Color color;
+      float intensity;
+    };
+
+    std::vector<Dome> domeLights;
+    std::vector<Direct> directLights;
+    std::vector<Point> pointLights;
+    std::vector<Area> areaLights;
+
+	  Color skyColor;
+	  Color sunColor;
+	  Vector3 sunDirection;
+	  //TODO: add additional point/area lights
+  };
+
+  std::shared_ptr<utils::heap::Heap> heap = nullptr;
+  std::shared_ptr<const scene::Scene> scene = nullptr;
+  std::shared_ptr<math::bpcd::Tracer> tracer = nullptr;
+  std::shared_ptr<rasterizer::Canvas> canvas = nullptr;
+  std::shared_ptr<rasterizer::Scanner> scanner = nullptr;
+
+  utils::img::Image result;
+  uint32_t seed = 345;  // base of the per worker seeds
+  bool deterministic = false;  // see SolverToolbox::key()
+  uint32_t deterministicSeed = 345;
+
+  struct Task : public utils::multithread::Task {
+   public:
+    int x, y;
+    Lighting lighting;
+
+    std::shared_ptr<const math::bpcd::Tracer> tracer;
+    math::Vector3 p;
+    math::Vector3 n;
+    Color c;
+    math::Vector3 result;
+    virtual void perform(utils::multithread::Toolbox *toolbox) override;
+  };
+
+  // tiled mode: one task shades a tileSize x tileSize block straight into result and the
+  // lighting is read from the solver instead of being copied into every task
+  static constexpr int tileSize = 16;
+  bool tiled = true;
+  Lighting lighting;
+  struct Tile : public utils::multithread::Task {
+    LightSolver *solver = nullptr;
+    int x0, y0, x1, y1;
+    virtual void perform(utils::multithread::Toolbox *toolbox) override;
+  };
+
+  // irradiance caching of the sky term (tiled only). create() queues nothing and each pass()
+  // visits the texels on a grid of stride texels, halving it every pass down to 1. a texel
+  // where cached records are valid blends them, any other traces the sky hemisphere and
+  // records it for later passes. the sun is traced for every texel. radii left at 0 in
+  // cacheConfig are scaled from the scene bounds
+  bool cached = false;
+  lightmap::IrradianceCache::Config cacheConfig;
+  std::unique_ptr<lightmap::IrradianceCache> cache;
+  int stride = 8;
+  int passes = 0;
+  std::vector<uint8_t> resolved;
+  std::mutex recordsMutex;
+  std::vector<std::pair<int, lightmap::IrradianceRecord>> fresh;  // made this pass, keyed by texel
+
+  // runs one cached pass, returning the number of texels still to be shaded
+  int pass();
+
+  using Toolbox = SolverToolbox;
+
+  static math::Vector3 illuminate(const math::bpcd::Tracer &tracer, const Lighting &lighting, math::Vector3 p, math::Vector3 n, Color c, Toolbox *tools);
+  // the cosine weighted sky seen from p, and the record of it with the harmonic mean
+  // distance to what its rays hit
+  static math::Vector3 skyLight(const math::bpcd::Tracer &tracer, const Lighting &lighting, math::Vector3 p, math::Vector3 n, Toolbox *tools);
+  static lightmap::IrradianceRecord skyRecord(const math::bpcd::Tracer &tracer, const Lighting &lighting, math::Vector3 p, math::Vector3 n, Toolbox *tools);
+  // adds the sun to the sky term and applies the albedo
+  static math::Vector3 shade(const math::bpcd::Tracer &tracer, const Lighting &lighting, math::Vector3 sky, math::Vector3 p, math::Vector3 n, Color c);
+
+  // called on every pool thread at once, so each worker's stream comes from its id alone
+  virtual std::unique_ptr<utils::multithread::Toolbox> divyToolbox(int workerId) override {
+    uint32_t workerSeed = math::sampling::pcgHash(seed ^ uint32_t(workerId));
+    return std::make_unique<Toolbox>(workerSeed, deterministic ? std::optional<uint32_t>(deterministicSeed) : std::nullopt);
+  }
+
+
+  LightSolver(std::shared_ptr<utils::heap::Heap> heap)
+      :
+      utils::multithread::Workers(heap, 512 * 512, 4096),
+      heap(heap) {
+  }
+  bool create(std::string_view fbxName, uint32_t rasterWidth, uint32_t rasterHeight, Lighting lighting, math::bpcd::TracerType tracerType = math::bpcd::TracerType::Grid);
+  bool create(std::shared_ptr<const scene::Scene> scene, uint32_t rasterWidth, uint32_t rasterHeight, Lighting lighting, math::bpcd::TracerType tracerType = math::bpcd::TracerType::Grid);
+  void save();
+
+ private:
+  void queueTiles();
+};
+
+}
+
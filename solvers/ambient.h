@@ -1,94 +1,344 @@
-#pragma once
-
-#include "solver.h"
-
-#include "../thirdparty/mtwister/mtwister.h"
-#include "../utils/image.h"
-#include "../math/noise.h"
-
-namespace mbz {
-namespace lightmap {
-
-struct AmbientOcclusionSolver : public Solver {
-  AmbientOcclusionSolver(LightmapBuilder &lightmapBuilder)
-      :
-      Solver(lightmapBuilder) {
-    utils::heap::Array<std::unique_ptr<Task>> tasks(lightmapBuilder.heap, 1);
-    prepTasks<Task>(tasks);
-    std::lock_guard<std::mutex> lg(todoMutex);
-    for (int i = 0; i < tasks.size; i++) {
-      todo.append_move(std::move(tasks.p()[i]));
-    }
-  }
-
-  struct Toolbox : public Solver::Toolbox {
-    MTRandWrapper mtRand;
-    Vector3 skyColor;
-    Vector3 randomPointOnSphere() {
-      return math::mc::randomPointOnSphere(mtRand);
-    }
-  };
-
-  virtual Solver::Toolbox* initToolbox(int workerId) override {
-    Toolbox *toolbox = new Toolbox();
-    toolbox->skyColor = (1.0f / 255.0f) * Vector3(212.0f, 250.0f, 250.0f);
-    toolbox->mtRand.seed(2654435761u + 374761393u * uint32_t(workerId));
-    return toolbox;
-  }
-
-  virtual ~AmbientOcclusionSolver() {
-  }
-
-  struct Task : public Solver::Task {
-    Vector3 final;
-    virtual void perform(utils::multithread::Toolbox *toolbox_) override {
-      Toolbox *toolbox = dynamic_cast<Toolbox*>(toolbox_);
-      const int N = 40;
-      int total = 0;
-      float sum = 0.0f;
-      while (total < N) {
-        auto d = toolbox->randomPointOnSphere();
-        if (d.dot(n) <= 0.0f)
-          continue;
-        total++;
-        Ray ray(p + 0.001 * n, d);
-        RaySeg raySeg(ray, 10.0f);
-        bpcd::Grid::Trace trace(raySeg);
-        toolbox->grid->traceRay(raySeg, trace);
-        if (!trace.point.has_value())
-          sum += d.dot(n);
-      }
-      sum *= 255.0f * 2.0f / float(N);
-      sum = std::clamp(sum, 0.0f, 255.0f);
-      final.x = sum * toolbox->skyColor.x;
-      final.y = sum * toolbox->skyColor.y;
-      final.z = sum * toolbox->skyColor.z;
-    }
-  };
-
-  void save(utils::img::Image &result, std::string_view filename = "") {
-    int w(lightmapBuilder.get().lightmap->canvas.w), h(lightmapBuilder.get().lightmap->canvas.h);
-    result.w = w;
-    result.h = h;
-    result.pixels = std::vector<Color>(w * h);
-
-    {
-      std::lock_guard<std::mutex> lg(completedMutex);
-      printf("completed size: %d\n", completed.size);
-      for (int i = 0; i < completed.size; i++) {
-        auto t = static_cast<Task*>(completed.p()[i].release());
-        result.pixels[t->y * w + t->x] = Color(t->final.x, t->final.y, t->final.z);
-        delete t;
-      }
-    }
-    if (filename.size()) {
-      utils::img::writeImageToPNGFile(result, filename.data());
-      LOGINFO("AmbientOcclusionSolver::save", "saved result to disk");
-    }
-  }
-
-};
-
-}
-}
-
+#pragma once
+
+#include "solver.h"
+#include "irradiance.h"
+
+#include "../utils/image.h"
+#include "../math/sampler.h"
+
+#include <mutex>
+#include <memory>
+#include <utility>
+
+namespace mbz {
+namespace lightmap {
+
+struct AmbientOcclusionSolver : public Solver {
+  // progressive baking: each pass() adds samplesPerPass rays to every texel that has not
+  // converged yet, that is whose standard error has dropped below tolerance (1 being
+  // unoccluded sky) after at least minSamples, or that has reached maxSamples
+  struct Progressive {
+    int samplesPerPass = 8;
+    int minSamples = 16;
+    int maxSamples = 256;
+    float tolerance = 0.02f;
+  };
+
+  // running mean and variance of a texel's samples (welford)
+  struct Estimate {
+    int count = 0;
+    float mean = 0.0f;
+    float m2 = 0.0f;
+    bool done = false;
+  };
+
+  bool tiled;
+  // keys every texel's samples by its coordinates and sample index instead of drawing them
+  // from the shading worker's stream, so results are bit identical for any thread count
+  bool deterministic = false;
+  uint32_t seed = 0;  // scrambles the deterministic sequences
+  bool progressive = false;
+  Progressive config;
+  std::vector<Estimate> estimates;
+  int passes = 0;
+
+  // irradiance caching: each pass() visits the texels on a grid of stride texels, halving
+  // it every pass down to 1. a texel where cached records are valid blends them, any other
+  // traces a full hemisphere record that later passes can reuse
+  static constexpr int recordRays = 64;
+  bool cached = false;
+  std::unique_ptr<IrradianceCache> cache;
+  int stride = 0;
+  std::vector<uint8_t> resolved;
+  std::mutex recordsMutex;
+  std::vector<std::pair<size_t, IrradianceRecord>> fresh;  // made this pass, keyed by texel
+
+  // tiled solvers shade whole blocks of texels per task, otherwise each texel is its own task
+  AmbientOcclusionSolver(LightmapBuilder &lightmapBuilder, bool tiled = true)
+      :
+      Solver(lightmapBuilder),
+      tiled(tiled) {
+    if (tiled) {
+      prepTiles(this);
+      return;
+    }
+    utils::heap::Array<std::unique_ptr<Task>> tasks(lightmapBuilder.heap, 1);
+    prepTasks<Task>(tasks);
+    std::lock_guard<std::mutex> lg(todoMutex);
+    for (int i = 0; i < tasks.size; i++) {
+      todo.append_move(std::move(tasks.p()[i]));
+    }
+  }
+
+  // progressive solvers queue nothing up front, every pass() is one run over the tiles
+  AmbientOcclusionSolver(LightmapBuilder &lightmapBuilder, Progressive config)
+      :
+      Solver(lightmapBuilder),
+      tiled(true),
+      progressive(true),
+      config(config) {
+    const auto &gbuffer = lightmapBuilder.lightmap->gbuffer;
+    output.w = gbuffer.w;
+    output.h = gbuffer.h;
+    output.pixels = std::vector<Color>(gbuffer.size());
+    estimates = std::vector<Estimate>(gbuffer.size());
+    const float *maskLayer = gbuffer.layer<0>();
+    for (size_t i = 0; i < gbuffer.size(); i++)
+      estimates[i].done = !maskLayer[i];
+  }
+
+  // cached solvers start with records every stride texels. radii left at 0 in cacheConfig
+  // are scaled from the scene bounds
+  AmbientOcclusionSolver(LightmapBuilder &lightmapBuilder, IrradianceCache::Config cacheConfig, int stride = 8)
+      :
+      Solver(lightmapBuilder),
+      tiled(true),
+      cached(true),
+      cache(std::make_unique<IrradianceCache>(cacheConfig.sized(lightmapBuilder.scene->bounds.size()))),
+      stride(std::max(1, stride)) {
+    const auto &gbuffer = lightmapBuilder.lightmap->gbuffer;
+    output.w = gbuffer.w;
+    output.h = gbuffer.h;
+    output.pixels = std::vector<Color>(gbuffer.size());
+    resolved = std::vector<uint8_t>(gbuffer.size());
+    const float *maskLayer = gbuffer.layer<0>();
+    for (size_t i = 0; i < gbuffer.size(); i++)
+      resolved[i] = !maskLayer[i];
+  }
+
+  // runs one progressive or cached pass, after which output holds the bake so far.
+  // returns the number of texels still to be worked on, 0 once the bake is done
+  int pass() {
+    if (cached)
+      return cachePass();
+    if (!progressive)
+      return 0;
+    queueTiles(this);
+    beginJoin();
+    releaseTiles();
+    passes++;
+    int active = 0;
+    for (const auto &estimate : estimates)
+      active += estimate.done ? 0 : 1;
+    LOGINFO("AmbientOcclusionSolver::pass", "pass %d: %d texels active", passes, active);
+    return active;
+  }
+
+  int cachePass() {
+    if (!stride)
+      return 0;
+    queueTiles(this);
+    beginJoin();
+    releaseTiles();
+    // records join the cache in texel order, so the cache does not depend on scheduling
+    std::sort(fresh.begin(), fresh.end(), [](const auto &a, const auto &b) {
+      return a.first < b.first;
+    });
+    for (auto &record : fresh)
+      cache->insert(record.second);
+    passes++;
+    int remaining = 0;
+    for (uint8_t done : resolved)
+      remaining += done ? 0 : 1;
+    LOGINFO("AmbientOcclusionSolver::pass", "pass %d (stride %d): %zu new records, %zu cached, %d texels left", passes, stride, fresh.size(), cache->size(),
+            remaining);
+    fresh.clear();
+    stride /= 2;
+    return remaining;
+  }
+
+  // where a texel's sample directions come from. keyed streams walk a sobol sequence
+  // scrambled per texel, the rest draw from the worker's pcg stream
+  struct Stream {
+    bool keyed = false;
+    uint32_t shiftX = 0, shiftY = 0;
+    uint32_t next = 0;  // sobol index of the next sample
+  };
+
+  struct Toolbox : public Solver::Toolbox {
+    math::sampling::Pcg32 rng;
+    Vector3 skyColor;
+    bool deterministic = false;
+    uint32_t seed = 0;
+
+    // the stream of texel (x, y), starting at its sample first
+    Stream stream(int x, int y, uint32_t first = 0) const {
+      Stream stream;
+      stream.keyed = deterministic;
+      if (deterministic) {
+        uint32_t key = math::sampling::random(seed, uint32_t(y) * 65536u + uint32_t(x));
+        stream.shiftX = math::sampling::random(key, 0);
+        stream.shiftY = math::sampling::random(key, 1);
+        stream.next = first;
+      }
+      return stream;
+    }
+  };
+
+  virtual Solver::Toolbox* initToolbox(int workerId) override {
+    Toolbox *toolbox = new Toolbox();
+    toolbox->skyColor = (1.0f / 255.0f) * Vector3(212.0f, 250.0f, 250.0f);
+    toolbox->rng.seed(2654435761u, uint64_t(workerId));
+    toolbox->deterministic = deterministic;
+    toolbox->seed = seed;
+    return toolbox;
+  }
+
+  virtual ~AmbientOcclusionSolver() {
+  }
+
+  // traces count cosine distributed rays over the hemisphere of n and writes 1 for each
+  // ray that escapes and 0 for each blocked one, so the mean is the cosine weighted
+  // unoccluded fraction and open texels have no variance
+  static void sampleOcclusion(Vector3 p, Vector3 n, int count, Stream &stream, Toolbox *toolbox, float *samples) {
+    constexpr int packetSize = bpcd::RayPacket::maxSize;
+    n = n.normalized();
+    math::sampling::Frame frame(n);
+    float u0[packetSize], u1[packetSize], x[packetSize], y[packetSize], z[packetSize];
+    bpcd::RayPacket packet;
+    for (int first = 0; first < count; first += packetSize) {
+      int size = std::min(packetSize, count - first);
+      for (int i = 0; i < size; i++) {
+        if (stream.keyed) {
+          Vector2 u = math::sampling::sobol(stream.next++, stream.shiftX, stream.shiftY);
+          u0[i] = u.x;
+          u1[i] = u.y;
+        } else {
+          u0[i] = toolbox->rng.uniform();
+          u1[i] = toolbox->rng.uniform();
+        }
+      }
+      math::sampling::cosineHemisphere(u0, u1, size, x, y, z);
+      for (int i = 0; i < size; i++)
+        packet.push(RaySeg(Ray(p + 0.001 * n, frame.toWorld(Vector3(x[i], y[i], z[i]))), 10.0f));
+      uint32_t blocked = toolbox->tracer->occluded(packet);
+      for (int i = 0; i < size; i++)
+        samples[first + i] = blocked & (1u << i) ? 0.0f : 1.0f;
+      packet.clear();
+    }
+  }
+
+  // a full hemisphere estimate at p that also measures how far away the surroundings are
+  static IrradianceRecord record(Vector3 p, Vector3 n, Stream &stream, Toolbox *toolbox) {
+    const float maxDist = 10.0f;
+    n = n.normalized();
+    math::sampling::Frame frame(n);
+    int unoccluded = 0;
+    float inverseDistances = 0.0f;
+    for (int i = 0; i < recordRays; i++) {
+      Vector2 u = stream.keyed ? math::sampling::sobol(stream.next++, stream.shiftX, stream.shiftY) : Vector2(toolbox->rng.uniform(), toolbox->rng.uniform());
+      RaySeg raySeg(Ray(p + 0.001 * n, frame.toWorld(math::sampling::cosineHemisphere(u))), maxDist);
+      bpcd::Trace trace(raySeg);
+      if (toolbox->tracer->traceRay(raySeg, trace)) {
+        inverseDistances += 1.0f / std::max(trace.raySeg.dist, 1e-4f);
+      } else {
+        unoccluded++;
+        inverseDistances += 1.0f / maxDist;
+      }
+    }
+    IrradianceRecord record;
+    record.p = p;
+    record.n = n;
+    record.value = skyLight(float(unoccluded) / float(recordRays), toolbox);
+    record.radius = float(recordRays) / inverseDistances;
+    return record;
+  }
+
+  static Vector3 skyLight(float unoccluded, Toolbox *toolbox) {
+    return std::clamp(255.0f * unoccluded, 0.0f, 255.0f) * toolbox->skyColor;
+  }
+
+  static Vector3 occlusion(Vector3 p, Vector3 n, Stream stream, Toolbox *toolbox) {
+    const int N = 40;
+    float samples[N];
+    sampleOcclusion(p, n, N, stream, toolbox, samples);
+    float sum = 0.0f;
+    for (int i = 0; i < N; i++)
+      sum += samples[i];
+    return skyLight(sum / float(N), toolbox);
+  }
+
+  // called by Tile for each covered texel
+  void shade(const Texel &texel, Toolbox *toolbox) {
+    size_t index = size_t(texel.y) * output.w + texel.x;
+    if (cached) {
+      if (resolved[index] || texel.x % stride || texel.y % stride)
+        return;
+      resolved[index] = 1;
+      Vector3 value;
+      if (!cache->lookup(texel.p, texel.n.normalized(), value)) {
+        Stream stream = toolbox->stream(texel.x, texel.y);
+        IrradianceRecord made = record(texel.p, texel.n, stream, toolbox);
+        value = made.value;
+        std::lock_guard<std::mutex> lg(recordsMutex);
+        fresh.emplace_back(index, made);
+      }
+      output.pixels[index] = Color(value.x, value.y, value.z);
+      return;
+    }
+    if (!progressive) {
+      Vector3 final = occlusion(texel.p, texel.n, toolbox->stream(texel.x, texel.y), toolbox);
+      output.pixels[index] = Color(final.x, final.y, final.z);
+      return;
+    }
+    Estimate &estimate = estimates[index];
+    if (estimate.done)
+      return;
+    float samples[bpcd::RayPacket::maxSize];
+    Stream stream = toolbox->stream(texel.x, texel.y, uint32_t(estimate.count));
+    for (int left = std::max(1, config.samplesPerPass); left > 0;) {
+      int count = std::min(left, bpcd::RayPacket::maxSize);
+      sampleOcclusion(texel.p, texel.n, count, stream, toolbox, samples);
+      for (int i = 0; i < count; i++) {
+        estimate.count++;
+        float delta = samples[i] - estimate.mean;
+        estimate.mean += delta / float(estimate.count);
+        estimate.m2 += delta * (samples[i] - estimate.mean);
+      }
+      left -= count;
+    }
+    if (estimate.count >= config.maxSamples)
+      estimate.done = true;
+    else if (estimate.count >= std::max(2, config.minSamples))
+      estimate.done = estimate.m2 / float(estimate.count - 1) / float(estimate.count) <= config.tolerance * config.tolerance;
+    Vector3 final = skyLight(estimate.mean, toolbox);
+    output.pixels[index] = Color(final.x, final.y, final.z);
+  }
+
+  struct Task : public Solver::Task {
+    Vector3 final;
+    virtual void perform(utils::multithread::Toolbox *toolbox_) override {
+      auto toolbox = dynamic_cast<Toolbox*>(toolbox_);
+      final = occlusion(p, n, toolbox->stream(x, y), toolbox);
+    }
+  };
+
+  void save(utils::img::Image &result, std::string_view filename = "") {
+    int w(lightmapBuilder.get().lightmap->gbuffer.w), h(lightmapBuilder.get().lightmap->gbuffer.h);
+    result.w = w;
+    result.h = h;
+    result.pixels = std::vector<Color>(w * h);
+
+    if (tiled) {
+      releaseTiles();
+      result.pixels = output.pixels;
+    } else {
+      std::lock_guard<std::mutex> lg(completedMutex);
+      printf("completed size: %d\n", completed.size);
+      for (int i = 0; i < completed.size; i++) {
+        auto t = static_cast<Task*>(completed.p()[i].release());
+        result.pixels[t->y * w + t->x] = Color(t->final.x, t->final.y, t->final.z);
+        delete t;
+      }
+    }
+    if (filename.size()) {
+      utils::img::writeImageToPNGFile(result, filename.data());
+      LOGINFO("AmbientOcclusionSolver::save", "saved result to disk");
+    }
+  }
+
+};
+
+}
+}
+
@@ -1,43 +1,41 @@
-#pragma once
-
-#include "lightmap.h"
-#include "../math/bpcd/grid.h"
-
-#include <array>
-#include <vector>
-#include <string_view>
-#include <memory>
-
-namespace mbz {
-namespace lightmap {
-
-struct LightmapBuilder {
-  struct Vertex {
-    math::Vector3 p;
-    math::Vector3 n;
-    math::Vector2 uv1;
-    math::Vector2 uv2;
-  };
-
-  std::shared_ptr<utils::heap::Heap> heap = nullptr;
-  std::shared_ptr<Lightmap> lightmap = nullptr;
-  std::shared_ptr<math::bpcd::Grid> grid = nullptr;
-
-  utils::heap::Array<Vertex> vertices;
-  utils::heap::Array<std::array<int, 4>> triangles;
-
-  LightmapBuilder(std::shared_ptr<utils::heap::Heap> heap, std::shared_ptr<Lightmap> lightmap)
-      :
-      heap(heap),
-      lightmap(lightmap),
-      vertices(heap, 12),
-      triangles(heap, 4) {
-  }
-
-  bool buildFromFBX(std::string_view fbxName, float cellScale = 0.125f);
-
-};
-
-}
-}
-
+#pragma once
+
+#include "lightmap.h"
+#include "../math/bpcd/grid.h"
+#include "../math/bpcd/tracer.h"
+#include "../scene/scene.h"
+
+#include <array>
+#include <vector>
+#include <string_view>
+#include <memory>
+
+namespace mbz {
+namespace lightmap {
+
+struct LightmapBuilder {
+  std::shared_ptr<utils::heap::Heap> heap = nullptr;
+  std::shared_ptr<Lightmap> lightmap = nullptr;
+  std::shared_ptr<math::bpcd::Grid> grid = nullptr;  // only set when the tracer is a grid
+  std::shared_ptr<math::bpcd::Tracer> tracer = nullptr;  // shared with the scene
+  std::shared_ptr<const scene::Scene> scene = nullptr;
+
+  bool conservative = false;  // draw every texel a uv triangle touches, not only those it covers
+  int dilation = 0;  // texels to grow the charts by once drawn, so samples near seams stay inside
+
+  LightmapBuilder(std::shared_ptr<utils::heap::Heap> heap, std::shared_ptr<Lightmap> lightmap)
+      :
+      heap(heap),
+      lightmap(lightmap) {
+  }
+
+  // cellScale is a fraction of each mesh's extent, 0 lets the grids pick their own resolution
+  bool build(std::shared_ptr<const scene::Scene> scene, float cellScale = 0.0f, math::bpcd::TracerType tracerType = math::bpcd::TracerType::Grid);
+  // loads the scene through scene::Scene::load(), so it is shared with anyone else using it
+  bool buildFromFBX(std::string_view fbxName, float cellScale = 0.0f, math::bpcd::TracerType tracerType = math::bpcd::TracerType::Grid);
+
+};
+
+}
+}
+
@@ -0,0 +1,78 @@
+#include "irradiance.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace mbz {
+namespace lightmap {
+
+IrradianceCacheConfig IrradianceCacheConfig::sized(const math::Vector3 &size) const {
+  IrradianceCacheConfig config = *this;
+  float diagonal = std::max(size.length(), 1e-3f);
+  if (config.minRadius <= 0.0f)
+    config.minRadius = diagonal / 200.0f;
+  if (config.maxRadius <= 0.0f)
+    config.maxRadius = diagonal / 10.0f;
+  config.maxRadius = std::max(config.maxRadius, config.minRadius);
+  return config;
+}
+
+IrradianceCache::IrradianceCache(Config config)
+    :
+    config(config) {
+}
+
+float IrradianceCache::clampRadius(float radius) const {
+  return std::clamp(radius, config.minRadius, config.maxRadius);
+}
+
+uint64_t IrradianceCache::cellKey(int x, int y, int z) const {
+  // 21 bits per axis, plenty for any scene measured in maxRadius cells
+  auto bits = [](int v) {
+    return uint64_t(uint32_t(v) & 0x1fffffu);
+  };
+  return bits(x) | (bits(y) << 21) | (bits(z) << 42);
+}
+
+int IrradianceCache::cellOf(float v) const {
+  return int(std::floor(v / config.maxRadius));
+}
+
+bool IrradianceCache::lookup(const math::Vector3 &p, const math::Vector3 &n, math::Vector3 &value) const {
+  auto found = cells.find(cellKey(cellOf(p.x), cellOf(p.y), cellOf(p.z)));
+  if (found == cells.end())
+    return false;
+  float weights = 0.0f;
+  math::Vector3 sum;
+  for (uint32_t i : found->second) {
+    const IrradianceRecord &record = records[i];
+    float error = (p - record.p).length() / record.radius + std::sqrt(std::max(0.0f, 1.0f - n.dot(record.n)));
+    if (error >= config.accuracy)
+      continue;
+    float weight = 1.0f / std::max(error, 1e-4f);
+    sum = sum + weight * record.value;
+    weights += weight;
+  }
+  if (weights <= 0.0f)
+    return false;
+  value = (1.0f / weights) * sum;
+  return true;
+}
+
+void IrradianceCache::insert(IrradianceRecord record) {
+  record.radius = clampRadius(record.radius);
+  uint32_t index = uint32_t(records.size());
+  records.push_back(record);
+  // the record is valid within accuracy * radius of its point at most
+  float reach = config.accuracy * record.radius;
+  int x0 = cellOf(record.p.x - reach), x1 = cellOf(record.p.x + reach);
+  int y0 = cellOf(record.p.y - reach), y1 = cellOf(record.p.y + reach);
+  int z0 = cellOf(record.p.z - reach), z1 = cellOf(record.p.z + reach);
+  for (int z = z0; z <= z1; z++)
+    for (int y = y0; y <= y1; y++)
+      for (int x = x0; x <= x1; x++)
+        cells[cellKey(x, y, z)].push_back(index);
+}
+
+}
+}
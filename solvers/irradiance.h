@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../math/vector.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace mbz {
+namespace lightmap {
+
+// a full hemisphere estimate at one point. radius is the harmonic mean distance to what
+// the estimate's rays hit, clamped, and bounds how far the record can be reused
+struct IrradianceRecord {
+  math::Vector3 p;
+  math::Vector3 n;
+  math::Vector3 value;
+  float radius;
+};
+
+// radii are in world units. left at 0 they are picked by sized() from the scene's size
+struct IrradianceCacheConfig {
+  float accuracy = 0.25f;
+  float minRadius = 0.0f;
+  float maxRadius = 0.0f;
+
+  // the config for a scene whose bounds measure size, with any radius left at 0 set to a
+  // fixed fraction of its diagonal. solvers apply it before making their cache
+  IrradianceCacheConfig sized(const math::Vector3 &size) const;
+};
+
+// ward style irradiance cache. a record is valid at p, n while its error
+// |p - pi| / Ri + sqrt(1 - n.ni) stays below accuracy, and a lookup blends every valid
+// record weighted by the inverse of that error. records live in a hash grid of maxRadius
+// sized cells, each record in every cell its valid region overlaps, so a lookup reads a
+// single cell. the cache is only read while solvers run and grows between runs
+class IrradianceCache {
+ public:
+  using Config = IrradianceCacheConfig;
+
+  IrradianceCache(Config config = Config());
+
+  // false when no record is valid at p, n
+  bool lookup(const math::Vector3 &p, const math::Vector3 &n, math::Vector3 &value) const;
+  void insert(IrradianceRecord record);
+
+  size_t size() const {
+    return records.size();
+  }
+
+  float clampRadius(float radius) const;
+
+ private:
+  Config config;
+  std::vector<IrradianceRecord> records;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+
+  uint64_t cellKey(int x, int y, int z) const;
+  int cellOf(float v) const;
+};
+
+}
+}
@@ -1,87 +1,179 @@
-#pragma once
-
-#include "builder.h"
-#include "../utils/workers.h"
-
-
-namespace mbz {
-namespace lightmap {
-
-class Solver : public utils::multithread::Workers<15> {
- public:
-  struct Toolbox : public utils::multithread::Toolbox {
-    std::shared_ptr<const Lightmap> lightmap = nullptr;
-    std::shared_ptr<const math::bpcd::Grid> grid = nullptr;
-  };
-
-  struct Task : public utils::multithread::Task {
-    int x, y;
-    Vector3 p;
-    Vector3 n;
-    Color c;
-  };
-
-  template<typename T>
-  void prepTasks(utils::heap::Array<std::unique_ptr<T>> &tasks) {
-    static_assert(std::is_base_of<Task, T>::value,
-        "T is not a subclass of Task");
-    for (int i = 0; i < tasks.size; i++)
-      if (tasks.p()[i]) {
-        tasks.p()[i].reset();
-      }
-    tasks.release();
-
-    auto lightmap = lightmapBuilder.get().lightmap;
-    auto heap = lightmapBuilder.get().heap;
-
-    int h = lightmap->canvas.h;
-    int w = lightmap->canvas.w;
-
-    auto &maskLayer = lightmap->getLayer<0>();
-    auto &positionLayer = lightmap->getLayer<1>();
-    auto &normalLayer = lightmap->getLayer<2>();
-    auto &albedoLayer = lightmap->getLayer<3>();
-
-    tasks.init(heap, w * h);
-    for (int y = 0; y < h; y++) {
-      for (int x = 0; x < w; x++) {
-        int index = lightmap->canvas.xy(x, y);
-        if (!maskLayer[index].v)
-          continue;
-        std::unique_ptr<T> task = std::make_unique<T>();
-        task->x = x;
-        task->y = y;
-        task->p = positionLayer[index].v;
-        task->n = normalLayer[index].v;
-        task->c = albedoLayer[index].v.sample();
-        tasks.append_move(std::move(task));
-      }
-    }
-  }
-
-  std::reference_wrapper<LightmapBuilder> lightmapBuilder;
-  virtual Toolbox* initToolbox(int index) = 0;
-
-  virtual std::unique_ptr<utils::multithread::Toolbox> divyToolbox(int workerId) override {
-    std::unique_ptr<Toolbox> toolbox = std::unique_ptr<Toolbox>(initToolbox(workerId));
-
-    toolbox->grid = lightmapBuilder.get().grid;
-    toolbox->lightmap = lightmapBuilder.get().lightmap;
-    return toolbox;
-  }
-
-  Solver(std::reference_wrapper<LightmapBuilder> lightmapBuilder_)
-      :
-      utils::multithread::Workers<15>(lightmapBuilder_.get().heap, 512 * 512, 128),
-      lightmapBuilder(lightmapBuilder_) {
-  }
-
-  virtual ~Solver() {
-  }
-
-};
-
-
-}
-}
-
+#pragma once
+
+#include "builder.h"
+#include "../utils/workers.h"
+#include "../utils/image.h"
+
+#include <algorithm>
+
+
+namespace mbz {
+namespace lightmap {
+
+class Solver : public utils::multithread::Workers {
+ public:
+  struct Toolbox : public utils::multithread::Toolbox {
+    std::shared_ptr<const Lightmap> lightmap = nullptr;
+    std::shared_ptr<const math::bpcd::Tracer> tracer = nullptr;
+  };
+
+  struct Task : public utils::multithread::Task {
+    int x, y;
+    Vector3 p;
+    Vector3 n;
+    Color c;
+  };
+
+  template<typename T>
+  void prepTasks(utils::heap::Array<std::unique_ptr<T>> &tasks) {
+    static_assert(std::is_base_of<Task, T>::value,
+        "T is not a subclass of Task");
+    for (int i = 0; i < tasks.size; i++)
+      if (tasks.p()[i]) {
+        tasks.p()[i].reset();
+      }
+    tasks.release();
+
+    auto lightmap = lightmapBuilder.get().lightmap;
+    auto heap = lightmapBuilder.get().heap;
+
+    const auto &gbuffer = lightmap->gbuffer;
+    int h = gbuffer.h;
+    int w = gbuffer.w;
+
+    const float *maskLayer = gbuffer.layer<0>();
+    const Vector3 *positionLayer = gbuffer.layer<1>();
+    const Vector3 *normalLayer = gbuffer.layer<2>();
+    const rasterizer::PackedTexel *albedoLayer = gbuffer.layer<3>();
+
+    tasks.init(heap, w * h);
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        int index = gbuffer.xy(x, y);
+        if (!maskLayer[index])
+          continue;
+        std::unique_ptr<T> task = std::make_unique<T>();
+        task->x = x;
+        task->y = y;
+        task->p = positionLayer[index];
+        task->n = normalLayer[index];
+        task->c = albedoLayer[index].sample();
+        tasks.append_move(std::move(task));
+      }
+    }
+  }
+
+  static constexpr int tileSize = 16;
+
+  // what a tile hands its solver for every covered texel
+  struct Texel {
+    int x, y;
+    Vector3 p;
+    Vector3 n;
+    Color c;
+  };
+
+  // one task per tileSize x tileSize block of the lightmap. S::shade(texel, toolbox) is
+  // called directly for each covered texel and writes its result into S::output, so no
+  // per texel task is allocated. tiles never overlap, so no two threads share a pixel
+  template<typename S>
+  struct Tile : public utils::multithread::Task {
+    S *solver = nullptr;
+    int x0, y0, x1, y1;
+    virtual void perform(utils::multithread::Toolbox *toolbox_) override {
+      auto toolbox = static_cast<typename S::Toolbox*>(toolbox_);
+      const auto &gbuffer = solver->lightmapBuilder.get().lightmap->gbuffer;
+      const float *maskLayer = gbuffer.template layer<0>();
+      const Vector3 *positionLayer = gbuffer.template layer<1>();
+      const Vector3 *normalLayer = gbuffer.template layer<2>();
+      const rasterizer::PackedTexel *albedoLayer = gbuffer.template layer<3>();
+      Texel texel;
+      for (texel.y = y0; texel.y < y1; texel.y++) {
+        for (texel.x = x0; texel.x < x1; texel.x++) {
+          size_t index = gbuffer.xy(texel.x, texel.y);
+          if (!maskLayer[index])
+            continue;
+          texel.p = positionLayer[index];
+          texel.n = normalLayer[index];
+          texel.c = albedoLayer[index].sample();
+          solver->shade(texel, toolbox);
+        }
+      }
+    }
+  };
+
+  // queues one Tile<S> per block holding a covered texel and clears output to black
+  template<typename S>
+  void prepTiles(S *solver, int size = tileSize) {
+    const auto &gbuffer = lightmapBuilder.get().lightmap->gbuffer;
+    output.w = gbuffer.w;
+    output.h = gbuffer.h;
+    output.pixels = std::vector<Color>(size_t(gbuffer.w) * gbuffer.h);
+    queueTiles(solver, size);
+  }
+
+  // queues the tiles again, leaving output as it is
+  template<typename S>
+  void queueTiles(S *solver, int size = tileSize) {
+    const auto &gbuffer = lightmapBuilder.get().lightmap->gbuffer;
+    int h = gbuffer.h;
+    int w = gbuffer.w;
+
+    const float *maskLayer = gbuffer.layer<0>();
+    std::lock_guard<std::mutex> lg(todoMutex);
+    for (int y = 0; y < h; y += size) {
+      for (int x = 0; x < w; x += size) {
+        int x1 = std::min(w, x + size);
+        int y1 = std::min(h, y + size);
+        bool covered = false;
+        for (int j = y; j < y1 && !covered; j++)
+          for (int i = x; i < x1 && !covered; i++)
+            covered = maskLayer[gbuffer.xy(i, j)] != 0.0f;
+        if (!covered)
+          continue;
+        auto tile = std::make_unique<Tile<S>>();
+        tile->solver = solver;
+        tile->x0 = x;
+        tile->y0 = y;
+        tile->x1 = x1;
+        tile->y1 = y1;
+        todo.append_move(std::move(tile));
+      }
+    }
+  }
+
+  // drops finished tiles, their results already sit in output
+  void releaseTiles() {
+    std::lock_guard<std::mutex> lg(completedMutex);
+    for (int i = 0; i < completed.size; i++)
+      completed.p()[i].reset();
+    completed.size = 0;
+  }
+
+  std::reference_wrapper<LightmapBuilder> lightmapBuilder;
+  utils::img::Image output;
+  virtual Toolbox* initToolbox(int index) = 0;
+
+  virtual std::unique_ptr<utils::multithread::Toolbox> divyToolbox(int workerId) override {
+    std::unique_ptr<Toolbox> toolbox = std::unique_ptr<Toolbox>(initToolbox(workerId));
+
+    toolbox->tracer = lightmapBuilder.get().tracer;
+    toolbox->lightmap = lightmapBuilder.get().lightmap;
+    return toolbox;
+  }
+
+  Solver(std::reference_wrapper<LightmapBuilder> lightmapBuilder_)
+      :
+      utils::multithread::Workers(lightmapBuilder_.get().heap, 512 * 512, 128),
+      lightmapBuilder(lightmapBuilder_) {
+  }
+
+  virtual ~Solver() {
+  }
+
+};
+
+
+}
+}
+
@@ -1,425 +1,938 @@
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <mutex>
-#include <set>
-#include <map>
-#include <string>
-
-#include "utils/log.h"
-#include "utils/file.h"
-#include "utils/heap.h"
-#include "utils/image.h"
-#include "utils/hash.h"
-#include "utils/workers.h"
-
-#include "math/vector.h"
-#include "math/geometry.h"
-#include "math/bcs.h"
-#include "math/noise.h"
-#include "math/bpcd/grid.h"
-
-#include "rasterizer/rasterizer.h"
-#include "thirdparty/mtwister/mtwister.h"
-#include "thirdparty/openfbx/ofbx.h"
-#include "thirdparty/lodepng/lodepng.h"
-
-using namespace mbz;
-using namespace mbz::math;
-
-void testHeap() {
-  utils::heap::Heap heap(64 * 1024 * 1024);
-  MTRandWrapper mt(1337);
-
-  LOGINFO(__FUNCTION__, "%f out of %f mbs reserved for use", (float ) (heap.total() - heap.remaining()) / (1024.0f * 1024.0f), float(heap.total()) / (1024.0f * 1024.0f));
-  utils::heap::Heap::Tile *allocs[200] = { NULL };
-  int requested = 0;
-  for (int i = 0; i < 5000; i++) {
-    int n = mt.randomLong() % 200;
-    if (mt.randomBool() && allocs[n]) {
-      heap.release(allocs[n]);
-      allocs[n] = nullptr;
-    }
-    int size = mt.randomLong() % (16 * 1024) + 1;  // allocate random sized memory between 1 and 16k bytes
-    allocs[n] = heap.reserve(size);
-    requested += size;
-  }
-
-  float recycle_rate = 100.0f * (float) heap.recycles / (float) (heap.reservations + heap.recycles);
-  LOGINFO(__FUNCTION__, "reservations v. recycles: %d v %d (recycle rate ~%.2f%%)", heap.reservations, heap.recycles, recycle_rate);
-  LOGINFO(__FUNCTION__, "%f out of %f mbs reserved for use", ((float ) heap.total() - heap.remaining()) / (1024.0f * 1024.0f), (float ) heap.total() / (1024.0f * 1024.0f));
-  LOGINFO(__FUNCTION__, "%f mbs actually requested", (float ) requested / (1024.0f * 1024.0f));
-}
-
-void testBuffer() {
-  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(4096);
-  utils::heap::Array<int> buffer( heap, 8);
-
-  for(int i = 0; i < 128; i++){
-    buffer.append(i);
-    LOGINFO(__FUNCTION__, " %d (%u)", buffer[i], buffer.tile->size<int>());
-  }
-
-  float recycle_rate = 100.0f * (float) heap->recycles / (float) (heap->reservations + heap->recycles);
-  LOGINFO(__FUNCTION__, "reservations v. recycles: %d v %d (recycle rate ~%.2f%%)", heap->reservations, heap->recycles, recycle_rate);
-  LOGINFO(__FUNCTION__, "%f out of %f mbs reserved for use", ((float ) heap->total() - heap->remaining()) / (1024.0f * 1024.0f), (float ) heap->total() / (1024.0f * 1024.0f));
-}
-
-
-void testAABB() {
-  std::array<Vector3, 3> tri = { Vector3(1.0f, 1.0f, 0.0f),  // Point 1
-  Vector3(3.0f, 1.0f, 0.0f),  // Point 2
-  Vector3(2.0f, 3.0f, 0.0f)   // Point 3
-      };
-  Aabb aabb(Vector3(2.0f, 2.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f));
-  LOGINFO(__FUNCTION__, "collision with triangle: %s", aabb.collidesWith(tri) ? "yes" : "no");
-
-  aabb.p = Vector3();
-  Ray ray(Vector3(-5.0f, -5.0f, -4.0f), Vector3(1, 1, 1));  // A ray starting at (0, 0, -5) going in the +Z direction
-
-// Perform the intersection test
-  auto result = aabb.clip(ray);
-
-  if (result) {
-    // If there's an intersection, print the entry and exit points
-    LOGINFO(__FUNCTION__, "ray intersect:");
-    LOGINFO(__FUNCTION__, " + enter: {%f, %f, %f}", result->p.x, result->p.y, result->p.z);
-    LOGINFO(__FUNCTION__, " + exit.: {%f, %f, %f}", result->end().x, result->end().y, result->end().z);
-  }
-
-}
-
-void testIntersect() {
-  utils::img::Image texImage;
-  utils::img::Image renderImage;
-  utils::FileData data("assets/grass.bmp");
-  texImage.fromBMP(data.data, "grass");
-  renderImage.w = renderImage.h = 256;
-  renderImage.pixels = std::vector<Color>(renderImage.w * renderImage.h);
-  printf("texture: %d x %d\n", texImage.w, texImage.h);
-  printf("render area: %d x %d\n", renderImage.w, renderImage.h);
-
-  struct Vert {
-    Vector3 p;
-    Vector2 uv;
-    Color c;
-  };
-
-  Vert triVerts[3];
-  triVerts[0].p = Vector3(-0.5f, -0.5f, 0.01f);
-  triVerts[0].uv = Vector2(0.0f, 0.0f);
-  triVerts[0].c = Color(255, 0, 0);
-
-  triVerts[1].p = Vector3(0.5f, -0.25f, 0.02f);
-  triVerts[1].uv = Vector2(1.0f, 0.0f);
-  triVerts[1].c = Color(0, 255, 0);
-
-  triVerts[2].p = Vector3(0.2f, 0.35f, 0.03f);
-  triVerts[2].uv = Vector2(0.5f, 1.0f);
-  triVerts[2].c = Color(0, 0, 255);
-
-  Bcs3 bcs;
-  bcs.init(triVerts[0].p, triVerts[1].p, triVerts[2].p);
-
-  Vector3 o(0.0f, 0.0f, -2.0f);
-  for (int y = 0; y < renderImage.h; y++) {
-    for (int x = 0; x < renderImage.w; x++) {
-      Vector3 d;
-      d.x = float(x) / float(renderImage.w - 1) - 0.5f;
-      d.y = float(y) / float(renderImage.h - 1) - 0.5f;
-      d.z = 1.0f;
-      Ray ray(o, d);
-      auto coord = bcs.project(ray);
-      if (!coord.has_value())
-        continue;
-      if (!coord->inside())
-        continue;
-
-      Color c = triVerts[0].c.lerp(triVerts[1].c, coord->x);
-      c = c.lerp(triVerts[2].c, coord->y);
-      Vector2 uv = triVerts[0].uv + coord->x * (triVerts[1].uv - triVerts[0].uv);
-      uv += coord->y * (triVerts[2].uv - triVerts[0].uv);
-      uv.x *= renderImage.w;
-      uv.y *= renderImage.h;
-      renderImage.put(x, y, texImage.sample(uv.x, uv.y));
-    }
-  }
-  utils::img::writeImageToBMPFile(renderImage, "result.bmp");
-}
-
-void testFbx() {
-  utils::FileData data("assets/demo_scene.fbx");
-  ofbx::LoadFlags f =
-  //    ofbx::LoadFlags::IGNORE_MODELS |
-      ofbx::LoadFlags::IGNORE_BLEND_SHAPES | ofbx::LoadFlags::IGNORE_CAMERAS | ofbx::LoadFlags::IGNORE_LIGHTS |
-      //    ofbx::LoadFlags::IGNORE_TEXTURES |
-          ofbx::LoadFlags::IGNORE_SKIN | ofbx::LoadFlags::IGNORE_BONES | ofbx::LoadFlags::IGNORE_PIVOTS |
-          //    ofbx::LoadFlags::IGNORE_MATERIALS |
-          ofbx::LoadFlags::IGNORE_POSES | ofbx::LoadFlags::IGNORE_VIDEOS | ofbx::LoadFlags::IGNORE_LIMBS |
-          //    ofbx::LoadFlags::IGNORE_MESHES |
-          ofbx::LoadFlags::IGNORE_ANIMATIONS;
-
-  auto scene = ofbx::load(data.data.data(), data.data.size(), ofbx::u16(f));
-  if (!scene->getMeshCount()) {
-    printf("scene has no mesh\n");
-    return;
-  }
-  auto mesh = scene->getMesh(0);
-  printf(" * mesh: %s\n", mesh->name);
-  for (int i = 0; i < mesh->getMaterialCount(); i++) {
-    printf("    + material: '%s'\n", mesh->getMaterial(i)->name);
-  }
-  const auto &geom = mesh->getGeometry()->getGeometryData();
-  for (int i = 0; i < geom.getPartitionCount(); i++) {
-    const auto &par = geom.getPartition(i);
-    printf("    + partition: %d polygons\n", par.polygon_count);
-//    for (int j = 0; j < par.polygon_count; j++) {
-//      auto poly = par.polygons[j];
-//      printf("       - [ %d, %d ]\n", poly.from_vertex, poly.vertex_count);
-//    }
-
-  }
-  auto positions = geom.getPositions();
-  auto normals = geom.getNormals();
-  auto uvs = geom.getUVs(0);
-  auto uv2s = geom.getUVs(1);
-  printf("    * %d positions\n", positions.count);
-  printf("    * %d normals\n", normals.count);
-  printf("    * %d texcoords (first)\n", uvs.count);
-  printf("    * %d texcoords (second)\n", uv2s.count);
-//  for(int i = 0; i < positions.count; i++){
-//    auto v = positions.get(i);
-//    printf("        - { %f, %f, %f }\n", v.x, v.y, v.z);
-//  }
-
-  auto export_partition = [&](ofbx::GeometryPartition par, ofbx::Vec2Attributes uv0s) {
-    FILE *fp = fopen("dump.obj", "w");
-    for (int i = 0; i < par.polygon_count; i++) {
-      auto poly = par.polygons[i];
-      auto p = positions.get(poly.from_vertex);
-      fprintf(fp, "v %f %f %f\n", p.x, p.y, p.z);
-      p = positions.get(poly.from_vertex + 1);
-      fprintf(fp, "v %f %f %f\n", p.x, p.y, p.z);
-      p = positions.get(poly.from_vertex + 2);
-      fprintf(fp, "v %f %f %f\n", p.x, p.y, p.z);
-    }
-    for (int i = 0; i < par.polygon_count; i++) {
-      auto poly = par.polygons[i];
-      auto t = uv0s.get(poly.from_vertex);
-      fprintf(fp, "vt %f %f\n", t.x, t.y);
-      t = uv0s.get(poly.from_vertex + 1);
-      fprintf(fp, "vt %f %f\n", t.x, t.y);
-      t = uv0s.get(poly.from_vertex + 2);
-      fprintf(fp, "vt %f %f\n", t.x, t.y);
-    }
-    int c = 1;
-    for (int i = 0; i < par.polygon_count; i++) {
-      fprintf(fp, "f %d/%d %d/%d %d/%d\n", c, c, c + 1, c + 1, c + 2, c + 2);
-      c += 3;
-    }
-    fclose(fp);
-  };
-
-  export_partition(geom.getPartition(0), uv2s);
-
-}
-
-void testMipmap() {
-  utils::FileData data("assets/grass.bmp");
-  utils::img::Image image;
-  image.fromBMP(data.data, "grass");
-  image.createMips();
-  int level = 1;
-  utils::img::Image *ptr = &image;
-  while (ptr->mip) {
-    std::string bmp = "mip" + std::to_string(level);
-    utils::img::writeImageToBMPFile(*ptr, bmp);
-    ptr = ptr->mip.get();
-    level++;
-  }
-}
-
-void testRasterization() {
-  /*
-   1. create canvas
-   2. load fbx file
-   3. load textures forthe materials
-   4. iterate over all the material faces and render to canvas
-   5. export canvas to image
-   */
-  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(64 * 1024 * 1024);
-  utils::FileData data("assets/demo_scene.fbx");
-  ofbx::LoadFlags f =
-  //    ofbx::LoadFlags::IGNORE_MODELS |
-      ofbx::LoadFlags::IGNORE_BLEND_SHAPES | ofbx::LoadFlags::IGNORE_CAMERAS | ofbx::LoadFlags::IGNORE_LIGHTS |
-      //    ofbx::LoadFlags::IGNORE_TEXTURES |
-          ofbx::LoadFlags::IGNORE_SKIN | ofbx::LoadFlags::IGNORE_BONES | ofbx::LoadFlags::IGNORE_PIVOTS |
-          //    ofbx::LoadFlags::IGNORE_MATERIALS |
-          ofbx::LoadFlags::IGNORE_POSES | ofbx::LoadFlags::IGNORE_VIDEOS | ofbx::LoadFlags::IGNORE_LIMBS |
-          //    ofbx::LoadFlags::IGNORE_MESHES |
-          ofbx::LoadFlags::IGNORE_ANIMATIONS;
-
-  auto scene = ofbx::load(data.data.data(), data.data.size(), ofbx::u16(f));
-  if (!scene->getMeshCount()) {
-    printf("scene has no mesh\n");
-    return;
-  }
-  auto mesh = scene->getMesh(0);
-  const auto &geom = mesh->getGeometry()->getGeometryData();
-
-  std::vector<int> textures(mesh->getMaterialCount());
-
-  for (int i = 0; i < mesh->getMaterialCount(); i++) {
-    std::string name(mesh->getMaterial(i)->name);
-    std::string file = "assets/" + name + ".png";
-    LOGINFO(__FUNCTION__, "loading texture '%s'", file.c_str());
-    uint32_t w, h;
-    std::vector<uint8_t> pixels;
-    auto error = lodepng::decode(pixels, w, h, file);
-    if (error) {
-      LOGERROR(__FUNCTION__, "PNG load failed: %s", lodepng_error_text(error));
-      continue;
-    }
-    LOGINFO(__FUNCTION__, " - texture size %d x %d", w, h);
-    utils::img::Image image;
-    image.w = w;
-    image.h = h;
-    image.pixels = std::vector<Color>(image.w * image.h);
-    for (int j = 0; j < int(w * h); j++) {
-      uint8_t r = pixels.data()[j * 4];
-      uint8_t g = pixels.data()[j * 4 + 1];
-      uint8_t b = pixels.data()[j * 4 + 2];
-      image.pixels.data()[j] = Color(r, g, b);
-    }
-    image.createMips();
-    rasterizer::loadTexture(image, name, textures[i]);
-  }
-
-  auto uvs = geom.getUVs(0);
-  auto uv2s = geom.getUVs(1);
-
-  std::vector<rasterizer::VariableType> types;
-  types.push_back(rasterizer::VariableType::TexelType);
-  rasterizer::Canvas canvas(heap, 1024, 1024, types);
-  rasterizer::Scanner scanner(canvas);
-  rasterizer::Point pts[3];
-  pts[0] = canvas.createPoint();
-  pts[1] = canvas.createPoint();
-  pts[2] = canvas.createPoint();
-
-  auto tov = [](ofbx::Vec2 v) {
-    return Vector2(v.x, v.y);
-  };
-
-  auto tri_area = [](Vector2 p, Vector2 p2, Vector2 p3) {
-    Vector2 u = p.point(p2);
-    Vector2 v = p.point(p3);
-    return 0.5f * (u.x * v.y - v.x * u.y);
-  };
-
-  math::Matrix2 M;
-  M.identity();
-  M.e00 = float(canvas.w - 1);
-  M.e11 = float(canvas.h - 1);
-  for (int i = 0; i < geom.getPartitionCount(); i++) {
-    int texHandle = textures[i];
-    auto par = geom.getPartition(i);
-    for (int j = 0; j < par.polygon_count; j++) {
-      auto poly = par.polygons[j];
-      Vector2 s1 = tov(uvs.get(poly.from_vertex));
-      Vector2 s2 = tov(uvs.get(poly.from_vertex + 1));
-      Vector2 s3 = tov(uvs.get(poly.from_vertex + 2));
-
-      Vector2 t1 = tov(uv2s.get(poly.from_vertex));
-      Vector2 t2 = tov(uv2s.get(poly.from_vertex + 1));
-      Vector2 t3 = tov(uv2s.get(poly.from_vertex + 2));
-
-      int level = utils::img::computeMipmapLevel(tri_area(t1, t2, t3), tri_area(s1, s2, s3)) - 1;
-
-      pts[0].p = M * s1;
-      std::get<rasterizer::TexelVariable>(pts[0].plot[0]).set(t1, texHandle, level);
-
-      pts[1].p = M * s2;
-      std::get<rasterizer::TexelVariable>(pts[1].plot[0]).set(t2, texHandle, level);
-
-      pts[2].p = M * s3;
-      std::get<rasterizer::TexelVariable>(pts[2].plot[0]).set(t3, texHandle, level);
-
-      scanner.buildEdge(pts[0], pts[1]);
-      scanner.buildEdge(pts[0], pts[2]);
-      scanner.buildEdge(pts[1], pts[2]);
-      scanner.scan();
-      scanner.reset();
-    }
-  }
-
-  auto &layer = std::get<rasterizer::TexelVariables>(canvas.layers[0]);
-  std::vector<Color> buffer;
-  buffer.reserve(layer.size);
-  for(int i = 0; i < layer.size; i++){
-    buffer.push_back(layer[i].v.sample());
-  }
-
-  utils::img::Image image;
-  image.w = int(canvas.w);
-  image.h = int(canvas.h);
-  image.pixels = std::move(buffer);
-  utils::img::writeImageToBMPFile(image, "rasterized");
-
-}
-
-
-void testHash() {
-  printf("*** TEST ***\n");
-  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(64 * 1024);
-  srand(123);
-  utils::heap::Hashmap<int> hashmap(16, [](const int &v) {
-    return utils::heap::hasher<int>(utils::heap::hasher(), v);
-  }
-                                    , heap);
-  for (int i = 0; i < 64; i++) {
-    printf("inserting %d...\n", i);
-    hashmap.insertIf(i);
-  }
-  hashmap.print();
-  printf("*****\n");
-  hashmap.resize();
-  hashmap.print();
-
-  int n;
-  utils::heap::Heap::Tile *tile = hashmap.getList(n);
-  utils::heap::Hashmap<int>::Container *list = tile->p<utils::heap::Hashmap<int>::Container>();
-
-  printf("COUNT: %d\n", n);
-  for (int i = 0; i < n; i++)
-    printf("%d\n", *list[i]());
-  heap->release(tile);
-
-  printf("%d elements (%d insertions)\n", hashmap.size(), hashmap.inserts);
-  float recycle_rate = 100.0f * (float) heap->recycles / (float) (heap->reservations + heap->recycles);
-  printf("reservations v. recycles: %d v %d (recycle rate ~%.2f%%)\n", heap->reservations, heap->recycles, recycle_rate);
-  printf("%f out of %f mbs reserved for use\n", ((float) heap->total() - heap->remaining()) / (1024.0f * 1024.0f), (float) heap->total() / (1024.0f * 1024.0f));
-}
-
-void testMultithread(){
-  auto heap = std::make_shared<utils::heap::Heap>(4 * 1024);
-   utils::multithread::Workers<8> workers(heap, 50);
-   struct Task : public utils::multithread::Task{
-     int x;
-     virtual void perform(utils::multithread::Toolbox *toolbox) override {
-       printf("x = %d\n", x);
-     }
-   };
-   for(int i = 0; i < 25; i++){
-     auto task = std::make_unique<Task>();
-     task->x = 123 + i;
-     workers.todo.append_move(std::move(task));
-   }
-   workers.begin();
-   workers.join();
-   for(int i = 0; i < workers.completed.size; i++){
-     Task *done = static_cast<Task*>(workers.completed.p()[i].release());
-     printf("done x = %d\n", done->x);
-     delete done;
-   }
-}
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <map>
+#include <string>
+
+#include "utils/log.h"
+#include "utils/file.h"
+#include "utils/heap.h"
+#include "utils/image.h"
+#include "utils/hash.h"
+#include "utils/workers.h"
+
+#include "math/vector.h"
+#include "math/geometry.h"
+#include "math/bcs.h"
+#include "math/noise.h"
+#include "math/sampler.h"
+#include "math/bpcd/grid.h"
+#include "math/bpcd/bvh.h"
+#include "math/bpcd/instances.h"
+
+#include "rasterizer/rasterizer.h"
+#include "rasterizer/raster.h"
+#include "rasterizer/binner.h"
+#include "rasterizer/dilation.h"
+#include "solvers/irradiance.h"
+#include "scene/scene.h"
+#include "thirdparty/mtwister/mtwister.h"
+#include "thirdparty/openfbx/ofbx.h"
+#include "thirdparty/lodepng/lodepng.h"
+
+using namespace mbz;
+using namespace mbz::math;
+
+void testHeap() {
+  utils::heap::Heap heap(64 * 1024 * 1024);
+  MTRandWrapper mt(1337);
+
+  LOGINFO(__FUNCTION__, "%f out of %f mbs reserved for use", (float ) (heap.total() - heap.remaining()) / (1024.0f * 1024.0f), float(heap.total()) / (1024.0f * 1024.0f));
+  utils::heap::Heap::Tile *allocs[200] = { NULL };
+  int requested = 0;
+  for (int i = 0; i < 5000; i++) {
+    int n = mt.randomLong() % 200;
+    if (mt.randomBool() && allocs[n]) {
+      heap.release(allocs[n]);
+      allocs[n] = nullptr;
+    }
+    int size = mt.randomLong() % (16 * 1024) + 1;  // allocate random sized memory between 1 and 16k bytes
+    allocs[n] = heap.reserve(size);
+    requested += size;
+  }
+
+  float recycle_rate = 100.0f * (float) heap.recycles / (float) (heap.reservations + heap.recycles);
+  LOGINFO(__FUNCTION__, "reservations v. recycles: %d v %d (recycle rate ~%.2f%%)", heap.reservations, heap.recycles, recycle_rate);
+  LOGINFO(__FUNCTION__, "%f out of %f mbs reserved for use", ((float ) heap.total() - heap.remaining()) / (1024.0f * 1024.0f), (float ) heap.total() / (1024.0f * 1024.0f));
+  LOGINFO(__FUNCTION__, "%f mbs actually requested", (float ) requested / (1024.0f * 1024.0f));
+}
+
+void testBuffer() {
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(4096);
+  utils::heap::Array<int> buffer( heap, 8);
+
+  for(int i = 0; i < 128; i++){
+    buffer.append(i);
+    LOGINFO(__FUNCTION__, " %d (%u)", buffer[i], buffer.tile->size<int>());
+  }
+
+  float recycle_rate = 100.0f * (float) heap->recycles / (float) (heap->reservations + heap->recycles);
+  LOGINFO(__FUNCTION__, "reservations v. recycles: %d v %d (recycle rate ~%.2f%%)", heap->reservations, heap->recycles, recycle_rate);
+  LOGINFO(__FUNCTION__, "%f out of %f mbs reserved for use", ((float ) heap->total() - heap->remaining()) / (1024.0f * 1024.0f), (float ) heap->total() / (1024.0f * 1024.0f));
+}
+
+
+void testAABB() {
+  std::array<Vector3, 3> tri = { Vector3(1.0f, 1.0f, 0.0f),  // Point 1
+  Vector3(3.0f, 1.0f, 0.0f),  // Point 2
+  Vector3(2.0f, 3.0f, 0.0f)   // Point 3
+      };
+  Aabb aabb(Vector3(2.0f, 2.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f));
+  LOGINFO(__FUNCTION__, "collision with triangle: %s", aabb.collidesWith(tri) ? "yes" : "no");
+
+  aabb.p = Vector3();
+  Ray ray(Vector3(-5.0f, -5.0f, -4.0f), Vector3(1, 1, 1));  // A ray starting at (0, 0, -5) going in the +Z direction
+
+// Perform the intersection test
+  auto result = aabb.clip(ray);
+
+  if (result) {
+    // If there's an intersection, print the entry and exit points
+    LOGINFO(__FUNCTION__, "ray intersect:");
+    LOGINFO(__FUNCTION__, " + enter: {%f, %f, %f}", result->p.x, result->p.y, result->p.z);
+    LOGINFO(__FUNCTION__, " + exit.: {%f, %f, %f}", result->end().x, result->end().y, result->end().z);
+  }
+
+}
+
+void testIntersect() {
+  utils::img::Image texImage;
+  utils::img::Image renderImage;
+  utils::FileData data("assets/grass.bmp");
+  texImage.fromBMP(data, "grass");
+  renderImage.w = renderImage.h = 256;
+  renderImage.pixels = std::vector<Color>(renderImage.w * renderImage.h);
+  printf("texture: %d x %d\n", texImage.w, texImage.h);
+  printf("render area: %d x %d\n", renderImage.w, renderImage.h);
+
+  struct Vert {
+    Vector3 p;
+    Vector2 uv;
+    Color c;
+  };
+
+  Vert triVerts[3];
+  triVerts[0].p = Vector3(-0.5f, -0.5f, 0.01f);
+  triVerts[0].uv = Vector2(0.0f, 0.0f);
+  triVerts[0].c = Color(255, 0, 0);
+
+  triVerts[1].p = Vector3(0.5f, -0.25f, 0.02f);
+  triVerts[1].uv = Vector2(1.0f, 0.0f);
+  triVerts[1].c = Color(0, 255, 0);
+
+  triVerts[2].p = Vector3(0.2f, 0.35f, 0.03f);
+  triVerts[2].uv = Vector2(0.5f, 1.0f);
+  triVerts[2].c = Color(0, 0, 255);
+
+  Bcs3 bcs;
+  bcs.init(triVerts[0].p, triVerts[1].p, triVerts[2].p);
+
+  Vector3 o(0.0f, 0.0f, -2.0f);
+  for (int y = 0; y < renderImage.h; y++) {
+    for (int x = 0; x < renderImage.w; x++) {
+      Vector3 d;
+      d.x = float(x) / float(renderImage.w - 1) - 0.5f;
+      d.y = float(y) / float(renderImage.h - 1) - 0.5f;
+      d.z = 1.0f;
+      Ray ray(o, d);
+      auto coord = bcs.project(ray);
+      if (!coord.has_value())
+        continue;
+      if (!coord->inside())
+        continue;
+
+      Color c = triVerts[0].c.lerp(triVerts[1].c, coord->x);
+      c = c.lerp(triVerts[2].c, coord->y);
+      Vector2 uv = triVerts[0].uv + coord->x * (triVerts[1].uv - triVerts[0].uv);
+      uv += coord->y * (triVerts[2].uv - triVerts[0].uv);
+      uv.x *= renderImage.w;
+      uv.y *= renderImage.h;
+      renderImage.put(x, y, texImage.sample(uv.x, uv.y));
+    }
+  }
+  utils::img::writeImageToBMPFile(renderImage, "result.bmp");
+}
+
+void testFbx() {
+  utils::FileData data("assets/demo_scene.fbx");
+  ofbx::LoadFlags f =
+  //    ofbx::LoadFlags::IGNORE_MODELS |
+      ofbx::LoadFlags::IGNORE_BLEND_SHAPES | ofbx::LoadFlags::IGNORE_CAMERAS | ofbx::LoadFlags::IGNORE_LIGHTS |
+      //    ofbx::LoadFlags::IGNORE_TEXTURES |
+          ofbx::LoadFlags::IGNORE_SKIN | ofbx::LoadFlags::IGNORE_BONES | ofbx::LoadFlags::IGNORE_PIVOTS |
+          //    ofbx::LoadFlags::IGNORE_MATERIALS |
+          ofbx::LoadFlags::IGNORE_POSES | ofbx::LoadFlags::IGNORE_VIDEOS | ofbx::LoadFlags::IGNORE_LIMBS |
+          //    ofbx::LoadFlags::IGNORE_MESHES |
+          ofbx::LoadFlags::IGNORE_ANIMATIONS;
+
+  auto scene = ofbx::load(data.data(), data.size(), ofbx::u16(f));
+  if (!scene->getMeshCount()) {
+    printf("scene has no mesh\n");
+    return;
+  }
+  auto mesh = scene->getMesh(0);
+  printf(" * mesh: %s\n", mesh->name);
+  for (int i = 0; i < mesh->getMaterialCount(); i++) {
+    printf("    + material: '%s'\n", mesh->getMaterial(i)->name);
+  }
+  const auto &geom = mesh->getGeometry()->getGeometryData();
+  for (int i = 0; i < geom.getPartitionCount(); i++) {
+    const auto &par = geom.getPartition(i);
+    printf("    + partition: %d polygons\n", par.polygon_count);
+//    for (int j = 0; j < par.polygon_count; j++) {
+//      auto poly = par.polygons[j];
+//      printf("       - [ %d, %d ]\n", poly.from_vertex, poly.vertex_count);
+//    }
+
+  }
+  auto positions = geom.getPositions();
+  auto normals = geom.getNormals();
+  auto uvs = geom.getUVs(0);
+  auto uv2s = geom.getUVs(1);
+  printf("    * %d positions\n", positions.count);
+  printf("    * %d normals\n", normals.count);
+  printf("    * %d texcoords (first)\n", uvs.count);
+  printf("    * %d texcoords (second)\n", uv2s.count);
+//  for(int i = 0; i < positions.count; i++){
+//    auto v = positions.get(i);
+//    printf("        - { %f, %f, %f }\n", v.x, v.y, v.z);
+//  }
+
+  auto export_partition = [&](ofbx::GeometryPartition par, ofbx::Vec2Attributes uv0s) {
+    FILE *fp = fopen("dump.obj", "w");
+    for (int i = 0; i < par.polygon_count; i++) {
+      auto poly = par.polygons[i];
+      auto p = positions.get(poly.from_vertex);
+      fprintf(fp, "v %f %f %f\n", p.x, p.y, p.z);
+      p = positions.get(poly.from_vertex + 1);
+      fprintf(fp, "v %f %f %f\n", p.x, p.y, p.z);
+      p = positions.get(poly.from_vertex + 2);
+      fprintf(fp, "v %f %f %f\n", p.x, p.y, p.z);
+    }
+    for (int i = 0; i < par.polygon_count; i++) {
+      auto poly = par.polygons[i];
+      auto t = uv0s.get(poly.from_vertex);
+      fprintf(fp, "vt %f %f\n", t.x, t.y);
+      t = uv0s.get(poly.from_vertex + 1);
+      fprintf(fp, "vt %f %f\n", t.x, t.y);
+      t = uv0s.get(poly.from_vertex + 2);
+      fprintf(fp, "vt %f %f\n", t.x, t.y);
+    }
+    int c = 1;
+    for (int i = 0; i < par.polygon_count; i++) {
+      fprintf(fp, "f %d/%d %d/%d %d/%d\n", c, c, c + 1, c + 1, c + 2, c + 2);
+      c += 3;
+    }
+    fclose(fp);
+  };
+
+  export_partition(geom.getPartition(0), uv2s);
+
+}
+
+void testMipmap() {
+  utils::FileData data("assets/grass.bmp");
+  utils::img::Image image;
+  image.fromBMP(data, "grass");
+  image.createMips();
+  int level = 1;
+  utils::img::Image *ptr = &image;
+  while (ptr->mip) {
+    std::string bmp = "mip" + std::to_string(level);
+    utils::img::writeImageToBMPFile(*ptr, bmp);
+    ptr = ptr->mip.get();
+    level++;
+  }
+}
+
+void testRasterization() {
+  /*
+   1. create canvas
+   2. load fbx file
+   3. load textures forthe materials
+   4. iterate over all the material faces and render to canvas
+   5. export canvas to image
+   */
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(64 * 1024 * 1024);
+  utils::FileData data("assets/demo_scene.fbx");
+  ofbx::LoadFlags f =
+  //    ofbx::LoadFlags::IGNORE_MODELS |
+      ofbx::LoadFlags::IGNORE_BLEND_SHAPES | ofbx::LoadFlags::IGNORE_CAMERAS | ofbx::LoadFlags::IGNORE_LIGHTS |
+      //    ofbx::LoadFlags::IGNORE_TEXTURES |
+          ofbx::LoadFlags::IGNORE_SKIN | ofbx::LoadFlags::IGNORE_BONES | ofbx::LoadFlags::IGNORE_PIVOTS |
+          //    ofbx::LoadFlags::IGNORE_MATERIALS |
+          ofbx::LoadFlags::IGNORE_POSES | ofbx::LoadFlags::IGNORE_VIDEOS | ofbx::LoadFlags::IGNORE_LIMBS |
+          //    ofbx::LoadFlags::IGNORE_MESHES |
+          ofbx::LoadFlags::IGNORE_ANIMATIONS;
+
+  auto scene = ofbx::load(data.data(), data.size(), ofbx::u16(f));
+  if (!scene->getMeshCount()) {
+    printf("scene has no mesh\n");
+    return;
+  }
+  auto mesh = scene->getMesh(0);
+  const auto &geom = mesh->getGeometry()->getGeometryData();
+
+  std::vector<int> textures(mesh->getMaterialCount());
+
+  for (int i = 0; i < mesh->getMaterialCount(); i++) {
+    std::string name(mesh->getMaterial(i)->name);
+    std::string file = "assets/" + name + ".png";
+    LOGINFO(__FUNCTION__, "loading texture '%s'", file.c_str());
+    uint32_t w, h;
+    std::vector<uint8_t> pixels;
+    auto error = lodepng::decode(pixels, w, h, file);
+    if (error) {
+      LOGERROR(__FUNCTION__, "PNG load failed: %s", lodepng_error_text(error));
+      continue;
+    }
+    LOGINFO(__FUNCTION__, " - texture size %d x %d", w, h);
+    utils::img::Image image;
+    image.w = w;
+    image.h = h;
+    image.pixels = std::vector<Color>(image.w * image.h);
+    for (int j = 0; j < int(w * h); j++) {
+      uint8_t r = pixels.data()[j * 4];
+      uint8_t g = pixels.data()[j * 4 + 1];
+      uint8_t b = pixels.data()[j * 4 + 2];
+      image.pixels.data()[j] = Color(r, g, b);
+    }
+    image.createMips();
+    rasterizer::loadTexture(image, name, textures[i]);
+  }
+
+  auto uvs = geom.getUVs(0);
+  auto uv2s = geom.getUVs(1);
+
+  std::vector<rasterizer::VariableType> types;
+  types.push_back(rasterizer::VariableType::TexelType);
+  rasterizer::Canvas canvas(heap, 1024, 1024, types);
+  rasterizer::Scanner scanner(canvas);
+  rasterizer::Point pts[3];
+  pts[0] = canvas.createPoint();
+  pts[1] = canvas.createPoint();
+  pts[2] = canvas.createPoint();
+
+  auto tov = [](ofbx::Vec2 v) {
+    return Vector2(v.x, v.y);
+  };
+
+  auto tri_area = [](Vector2 p, Vector2 p2, Vector2 p3) {
+    Vector2 u = p.point(p2);
+    Vector2 v = p.point(p3);
+    return 0.5f * (u.x * v.y - v.x * u.y);
+  };
+
+  math::Matrix2 M;
+  M.identity();
+  M.e00 = float(canvas.w - 1);
+  M.e11 = float(canvas.h - 1);
+  for (int i = 0; i < geom.getPartitionCount(); i++) {
+    int texHandle = textures[i];
+    auto par = geom.getPartition(i);
+    for (int j = 0; j < par.polygon_count; j++) {
+      auto poly = par.polygons[j];
+      Vector2 s1 = tov(uvs.get(poly.from_vertex));
+      Vector2 s2 = tov(uvs.get(poly.from_vertex + 1));
+      Vector2 s3 = tov(uvs.get(poly.from_vertex + 2));
+
+      Vector2 t1 = tov(uv2s.get(poly.from_vertex));
+      Vector2 t2 = tov(uv2s.get(poly.from_vertex + 1));
+      Vector2 t3 = tov(uv2s.get(poly.from_vertex + 2));
+
+      int level = utils::img::computeMipmapLevel(tri_area(t1, t2, t3), tri_area(s1, s2, s3)) - 1;
+
+      pts[0].p = M * s1;
+      std::get<rasterizer::TexelVariable>(pts[0].plot[0]).set(t1, texHandle, level);
+
+      pts[1].p = M * s2;
+      std::get<rasterizer::TexelVariable>(pts[1].plot[0]).set(t2, texHandle, level);
+
+      pts[2].p = M * s3;
+      std::get<rasterizer::TexelVariable>(pts[2].plot[0]).set(t3, texHandle, level);
+
+      scanner.buildEdge(pts[0], pts[1]);
+      scanner.buildEdge(pts[0], pts[2]);
+      scanner.buildEdge(pts[1], pts[2]);
+      scanner.scan();
+      scanner.reset();
+    }
+  }
+
+  auto &layer = std::get<rasterizer::TexelVariables>(canvas.layers[0]);
+  std::vector<Color> buffer;
+  buffer.reserve(layer.size);
+  for(int i = 0; i < layer.size; i++){
+    buffer.push_back(layer[i].v.sample());
+  }
+
+  utils::img::Image image;
+  image.w = int(canvas.w);
+  image.h = int(canvas.h);
+  image.pixels = std::move(buffer);
+  utils::img::writeImageToBMPFile(image, "rasterized");
+
+}
+
+
+void testHash() {
+  printf("*** TEST ***\n");
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(64 * 1024);
+  srand(123);
+  utils::heap::Hashmap<int> hashmap(16, [](const int &v) {
+    return utils::heap::hasher<int>(utils::heap::hasher(), v);
+  }
+                                    , heap);
+  for (int i = 0; i < 64; i++) {
+    printf("inserting %d...\n", i);
+    hashmap.insertIf(i);
+  }
+  hashmap.print();
+  printf("*****\n");
+  hashmap.resize();
+  hashmap.print();
+
+  int n;
+  utils::heap::Heap::Tile *tile = hashmap.getList(n);
+  utils::heap::Hashmap<int>::Container *list = tile->p<utils::heap::Hashmap<int>::Container>();
+
+  printf("COUNT: %d\n", n);
+  for (int i = 0; i < n; i++)
+    printf("%d\n", *list[i]());
+  heap->release(tile);
+
+  printf("%d elements (%d insertions)\n", hashmap.size(), hashmap.inserts);
+  float recycle_rate = 100.0f * (float) heap->recycles / (float) (heap->reservations + heap->recycles);
+  printf("reservations v. recycles: %d v %d (recycle rate ~%.2f%%)\n", heap->reservations, heap->recycles, recycle_rate);
+  printf("%f out of %f mbs reserved for use\n", ((float) heap->total() - heap->remaining()) / (1024.0f * 1024.0f), (float) heap->total() / (1024.0f * 1024.0f));
+}
+
+void testMultithread(){
+  auto heap = std::make_shared<utils::heap::Heap>(4 * 1024);
+   utils::multithread::Workers workers(heap, 50);
+   struct Task : public utils::multithread::Task{
+     int x;
+     virtual void perform(utils::multithread::Toolbox *toolbox) override {
+       printf("x = %d\n", x);
+     }
+   };
+   for(int i = 0; i < 25; i++){
+     auto task = std::make_unique<Task>();
+     task->x = 123 + i;
+     workers.todo.append_move(std::move(task));
+   }
+   workers.begin();
+   workers.join();
+   for(int i = 0; i < workers.completed.size; i++){
+     Task *done = static_cast<Task*>(workers.completed.p()[i].release());
+     printf("done x = %d\n", done->x);
+     delete done;
+   }
+}
+
+void testBvh() {
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(64 * 1024 * 1024);
+  MTRandWrapper mt(1337);
+  auto random = [&](float scale) {
+    return scale * (2.0f * float(mt.random()) - 1.0f);
+  };
+
+  std::vector<std::array<Vector3, 3>> tris;
+  for (int i = 0; i < 2000; i++) {
+    Vector3 p(random(4.0f), random(4.0f), random(4.0f));
+    tris.push_back( { p, p + Vector3(random(0.25f), random(0.25f), random(0.25f)), p + Vector3(random(0.25f), random(0.25f), random(0.25f)) });
+  }
+
+  bpcd::Grid grid(heap);
+  grid.build(tris, Vector3(0.5f, 0.5f, 0.5f));
+  // cells this big all hold too many triangles and get refined into sub-grids
+  bpcd::Grid coarse(heap);
+  coarse.build(tris, Vector3(2.0f, 2.0f, 2.0f));
+  bpcd::Bvh bvh;
+  bvh.build(tris);
+
+  int hits = 0, agree = 0, coarseAgree = 0, anyAgree = 0, total = 5000;
+  for (int i = 0; i < total; i++) {
+    Vector3 o(random(4.0f), random(4.0f), random(4.0f));
+    Vector3 d(random(1.0f), random(1.0f), random(1.0f));
+    RaySeg raySeg(Ray(o, d), 4.0f);
+    bpcd::Trace gridTrace(raySeg), bvhTrace(raySeg);
+    bool gridHit = grid.traceRay(raySeg, gridTrace);
+    bool bvhHit = bvh.traceRay(raySeg, bvhTrace);
+    hits += bvhHit ? 1 : 0;
+    if (gridHit == bvhHit && (!bvhHit || gridTrace.index == bvhTrace.index))
+      agree++;
+    if (grid.occluded(raySeg) == gridHit && bvh.occluded(raySeg) == bvhHit)
+      anyAgree++;
+    bpcd::Trace coarseTrace(raySeg);
+    bool coarseHit = coarse.traceRay(raySeg, coarseTrace);
+    if (coarseHit == bvhHit && (!bvhHit || coarseTrace.index == bvhTrace.index) && coarse.occluded(raySeg) == coarseHit)
+      coarseAgree++;
+  }
+  LOGINFO(__FUNCTION__, "%zu nodes, %d of %d rays hit, grid and bvh agree on %d", bvh.nodes.size(), hits, total, agree);
+  LOGINFO(__FUNCTION__, "any-hit and closest hit queries agree on %d of %d rays", anyAgree, total);
+  LOGINFO(__FUNCTION__, "%zu refined cells, refined grid and bvh agree on %d of %d rays", coarse.subGrids.size(), coarseAgree, total);
+
+  // packets of rays leaving one point, the way the AO solvers batch hemisphere samples. the
+  // packet any-hit must give every lane the scalar any-hit answer
+  int lanes = 0, lanesAgree = 0, lanesOccluded = 0;
+  for (int i = 0; i < total / bpcd::RayPacket::maxSize; i++) {
+    Vector3 o(random(4.0f), random(4.0f), random(4.0f));
+    bpcd::RayPacket packet;
+    while (packet.push(RaySeg(Ray(o, Vector3(random(1.0f), random(1.0f), random(1.0f))), 4.0f)))
+      ;
+    uint32_t blocked = bvh.occluded(packet);
+    for (int j = 0; j < packet.size; j++) {
+      RaySeg raySeg = packet.get(j);
+      bpcd::Trace trace(raySeg);
+      bool hit = bvh.traceRay(raySeg, trace);
+      lanes++;
+      lanesAgree += hit == ((blocked & (1u << j)) != 0) ? 1 : 0;
+      lanesOccluded += bvh.occluded(raySeg) == ((blocked & (1u << j)) != 0) ? 1 : 0;
+    }
+  }
+  LOGINFO(__FUNCTION__, "packet and single ray queries agree on %d of %d lanes, any-hit on %d", lanesAgree, lanes, lanesOccluded);
+  if (lanesOccluded != lanes)
+    LOGERROR(__FUNCTION__, "packet and single ray any-hit disagree");
+}
+
+void testGridBuild() {
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(64 * 1024 * 1024);
+  MTRandWrapper mt(7);
+  auto random = [&](float scale) {
+    return scale * (2.0f * float(mt.random()) - 1.0f);
+  };
+
+  std::vector<std::array<Vector3, 3>> tris;
+  for (int i = 0; i < 50000; i++) {
+    Vector3 p(random(16.0f), random(16.0f), random(16.0f));
+    tris.push_back( { p, p + Vector3(random(0.5f), random(0.5f), random(0.5f)), p + Vector3(random(0.5f), random(0.5f), random(0.5f)) });
+  }
+
+  uint64_t t0 = getCounter();
+  bpcd::Grid serial(heap);
+  serial.build(tris, Vector3(0.5f, 0.5f, 0.5f), false);
+  uint64_t t1 = getCounter();
+  bpcd::Grid parallel(heap);
+  parallel.build(tris, Vector3(0.5f, 0.5f, 0.5f), true);
+  uint64_t t2 = getCounter();
+
+  auto identical = [](const bpcd::Grid &a, const bpcd::Grid &b) {
+    bool same = a.numCells == b.numCells && a.cells.size() == b.cells.size() && a.triIndices.size() == b.triIndices.size()
+        && std::equal(a.triIndices.begin(), a.triIndices.end(), b.triIndices.begin());
+    for (size_t i = 0; same && i < a.cells.size(); i++) {
+      const auto &x = a.cells[i];
+      const auto &y = b.cells[i];
+      same = x.l == y.l && x.r == y.r && x.c == y.c && x.begin == y.begin && x.count == y.count && x.sub == y.sub;
+    }
+    return same;
+  };
+  double freq = double(getFreq());
+  LOGINFO(__FUNCTION__, "%d cells, serial %.3fs, parallel %.3fs, identical: %s", serial.numCells, double(t1 - t0) / freq, double(t2 - t1) / freq,
+          identical(serial, parallel) ? "yes" : "no");
+
+  // round trip through a cache file, which must refuse another key
+  uint64_t key = bpcd::Grid::cacheKey(tris, Vector3(0.5f, 0.5f, 0.5f));
+  parallel.save("test_grid.cache", key);
+  uint64_t t3 = getCounter();
+  bpcd::Grid cached(heap);
+  bool loaded = cached.load("test_grid.cache", key);
+  uint64_t t4 = getCounter();
+  bpcd::Grid stale(heap);
+  bool refused = !stale.load("test_grid.cache", key + 1);
+  LOGINFO(__FUNCTION__, "cache loaded in %.3fs: %s, identical: %s, other key refused: %s", double(t4 - t3) / freq, loaded ? "yes" : "no",
+          identical(parallel, cached) ? "yes" : "no", refused ? "yes" : "no");
+
+  // another build saved over the file leaves the grid mapping the old one intact
+  bpcd::Grid other(heap);
+  other.build(tris, Vector3(2.0f, 2.0f, 2.0f));
+  bool replaced = other.save("test_grid.cache", key + 1);
+  bool kept = identical(parallel, cached);
+  RaySeg seg(Vector3(-20.0f, 0.0f, 0.0f), Vector3(20.0f, 0.0f, 0.0f));
+  bpcd::Trace a(seg), b(seg);
+  kept = kept && cached.traceRay(seg, a) == parallel.traceRay(seg, b) && a.index == b.index;
+  LOGINFO(__FUNCTION__, "saved over a mapped cache: %s, mapped grid intact: %s", replaced ? "yes" : "no", kept ? "yes" : "no");
+  if (!replaced || !kept)
+    LOGERROR(__FUNCTION__, "cache replacement is off");
+  remove("test_grid.cache");
+
+  // a cache whose key matches but whose cell table size was edited is refused. cellMask
+  // sits 100 bytes into the header
+  parallel.save("test_grid.cache", key);
+  utils::FileData saved("test_grid.cache");
+  utils::FileData edited;
+  edited.bytes.assign(saved.data(), saved.data() + saved.size());
+  edited.bytes[100] ^= 0x10;
+  edited.save("test_grid.cache");
+  bpcd::Grid corrupt(heap);
+  if (corrupt.load("test_grid.cache", key))
+    LOGERROR(__FUNCTION__, "corrupt cache was mapped");
+  remove("test_grid.cache");
+
+  // saving a new key under a stem removes the file of the old one
+  parallel.save("test_grid.0000000000000001.grid", key);
+  other.save("test_grid.0000000000000002.grid", key + 1);
+  FILE *old = fopen("test_grid.0000000000000001.grid", "rb");
+  if (old) {
+    fclose(old);
+    LOGERROR(__FUNCTION__, "superseded cache was kept");
+  }
+  remove("test_grid.0000000000000001.grid");
+  remove("test_grid.0000000000000002.grid");
+
+  // the same triangles read through an index buffer build the same grid under the same key
+  std::vector<Vector3> positions;
+  std::vector<std::array<int, 4>> indices;
+  for (const auto &tri : tris) {
+    int base = int(positions.size());
+    positions.insert(positions.end(), tri.begin(), tri.end());
+    indices.push_back( { base, base + 1, base + 2, 0 });
+  }
+  bpcd::TriangleView view(positions.data(), sizeof(Vector3), indices[0].data(), 4, indices.size());
+  bpcd::Grid indexed(heap);
+  indexed.build(view, Vector3(0.5f, 0.5f, 0.5f), true);
+  bool sameKey = bpcd::Grid::cacheKey(view, Vector3(0.5f, 0.5f, 0.5f)) == key;
+  LOGINFO(__FUNCTION__, "indexed build identical: %s, same key: %s", identical(parallel, indexed) ? "yes" : "no", sameKey ? "yes" : "no");
+  if (!identical(parallel, indexed) || !sameKey)
+    LOGERROR(__FUNCTION__, "indexed build is off");
+
+  // no triangles builds nothing and traces nothing
+  auto empty = bpcd::createTracer(bpcd::TracerType::Grid, heap, bpcd::TriangleView(nullptr, sizeof(Vector3), nullptr, 4, 0));
+  RaySeg through(Vector3(-1.0f, -1.0f, -1.0f), Vector3(1.0f, 1.0f, 1.0f));
+  bpcd::Trace missed(through);
+  if (empty->traceRay(through, missed) || empty->occluded(through))
+    LOGERROR(__FUNCTION__, "empty grid hit something");
+
+  // a rebuild replaces the triangles of the last build, barycentric records included
+  std::vector<std::array<Vector3, 3>> few(tris.begin(), tris.begin() + 10);
+  indexed.build(few, Vector3(0.5f, 0.5f, 0.5f));
+  bool rebuilt = indexed.tris.size == int(few.size()) && indexed.triangles.size() == few.size();
+  for (size_t i = 0; rebuilt && i < few.size(); i++) {
+    Bcs3 bcs;
+    bcs.init(few[i][0], few[i][1], few[i][2]);
+    rebuilt = memcmp(&bcs, &indexed.tris[int(i)], sizeof(Bcs3)) == 0;
+  }
+  if (!rebuilt)
+    LOGERROR(__FUNCTION__, "rebuilt grid kept stale triangles");
+}
+
+void testRaster() {
+  // a uv layout of 224 x 224 quads split in two, about 100k triangles over 1024 x 1024
+  using Buffer = rasterizer::GBuffer<float, Vector2>;
+  Buffer gbuffer(1024, 1024);
+  rasterizer::Raster<Buffer> raster(gbuffer);
+  const int n = 224;
+  int size = int(gbuffer.w) - 1;
+  auto vertex = [&](int i, int j, float id) {
+    rasterizer::Raster<Buffer>::Vertex v;
+    v.p = Vector2(float(i * size) / float(n), float(j * size) / float(n));
+    v.values = { id, v.p };
+    return v;
+  };
+
+  uint64_t t0 = getCounter();
+  int written = 0;
+  for (int j = 0; j < n; j++) {
+    for (int i = 0; i < n; i++) {
+      float id = float(2 * (j * n + i) + 1);
+      written += raster.draw(vertex(i, j, id), vertex(i + 1, j, id), vertex(i + 1, j + 1, id));
+      written += raster.draw(vertex(i, j, id + 1), vertex(i + 1, j + 1, id + 1), vertex(i, j + 1, id + 1));
+    }
+  }
+  uint64_t t1 = getCounter();
+
+  // texels are written once each, every texel left of and above the layout's far edges is
+  // covered (those edges are bottom and right ones) and holds its own coordinate
+  int covered = 0, gaps = 0;
+  float maxError = 0.0f;
+  for (int y = 0; y < int(gbuffer.h); y++) {
+    for (int x = 0; x < int(gbuffer.w); x++) {
+      size_t index = gbuffer.xy(x, y);
+      if (gbuffer.at<0>(index) == 0.0f) {
+        gaps += x < size && y < size ? 1 : 0;
+        continue;
+      }
+      covered++;
+      Vector2 p = gbuffer.at<1>(index);
+      maxError = std::max(maxError, std::max(fabsf(p.x - float(x)), fabsf(p.y - float(y))));
+    }
+  }
+  LOGINFO(__FUNCTION__, "%d triangles in %.3fs, %d texels written, %d covered, %d gaps, max error %f", 2 * n * n, double(t1 - t0) / double(getFreq()),
+          written, covered, gaps, maxError);
+  if (written != covered || gaps)
+    LOGERROR(__FUNCTION__, "overlapping or missing texels");
+}
+
+void testBinnedRaster() {
+  // the same layout drawn serially and binned across the pool must match texel for texel
+  using Buffer = rasterizer::GBuffer<float, Vector2>;
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(16 * 1024 * 1024);
+  Buffer serial(1024, 1024), binned(1024, 1024);
+  rasterizer::Raster<Buffer> raster(serial);
+  rasterizer::BinnedRaster<Buffer> binnedRaster(binned, heap);
+  const int n = 224;
+  auto vertex = [&](int i, int j, float id) {
+    rasterizer::Raster<Buffer>::Vertex v;
+    // skewed so triangles straddle bin edges at odd angles
+    v.p = Vector2(float(i) * 1030.0f / float(n) - 3.0f + 0.37f * float(j % 5), float(j) * 1030.0f / float(n) - 3.0f);
+    v.values = { id, v.p };
+    return v;
+  };
+
+  for (int j = 0; j < n; j++) {
+    for (int i = 0; i < n; i++) {
+      float id = float(2 * (j * n + i) + 1);
+      auto a = vertex(i, j, id), b = vertex(i + 1, j, id), c = vertex(i + 1, j + 1, id);
+      raster.draw(a, b, c);
+      binnedRaster.add(a, b, c);
+      a = vertex(i, j, id + 1), b = vertex(i + 1, j + 1, id + 1), c = vertex(i, j + 1, id + 1);
+      raster.draw(a, b, c);
+      binnedRaster.add(a, b, c);
+    }
+  }
+  uint64_t t0 = getCounter();
+  int written = binnedRaster.flush();
+  uint64_t t1 = getCounter();
+
+  int mismatches = 0;
+  for (size_t i = 0; i < serial.size(); i++)
+    mismatches += serial.at<0>(i) != binned.at<0>(i) || serial.at<1>(i).x != binned.at<1>(i).x || serial.at<1>(i).y != binned.at<1>(i).y ? 1 : 0;
+  LOGINFO(__FUNCTION__, "%d triangles binned and drawn in %.3fs, %d texels written, %d mismatches", 2 * n * n, double(t1 - t0) / double(getFreq()),
+          written, mismatches);
+  if (mismatches)
+    LOGERROR(__FUNCTION__, "binned raster differs from the serial one");
+}
+
+void testDilation() {
+  // a conservative draw covers the exact one plus its border, and two dilation passes fill
+  // everything within two texels of the exact draw
+  using Buffer = rasterizer::GBuffer<float, Vector2>;
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(16 * 1024 * 1024);
+  Buffer exact(256, 256), conservative(256, 256);
+  rasterizer::Raster<Buffer> exactRaster(exact), conservativeRaster(conservative);
+  conservativeRaster.conservative = true;
+  rasterizer::Raster<Buffer>::Vertex vs[3];
+  Vector2 ps[3] = { Vector2(20.3f, 30.7f), Vector2(230.1f, 60.2f), Vector2(90.6f, 200.9f) };
+  for (int i = 0; i < 3; i++) {
+    vs[i].p = ps[i];
+    vs[i].values = { 1.0f, ps[i] };
+  }
+  int exactCount = exactRaster.draw(vs[0], vs[1], vs[2]);
+  int conservativeCount = conservativeRaster.draw(vs[0], vs[1], vs[2]);
+  int missing = 0;
+  for (size_t i = 0; i < exact.size(); i++)
+    missing += exact.at<0>(i) != 0.0f && conservative.at<0>(i) == 0.0f ? 1 : 0;
+
+  Buffer dilated = exact;
+  int filled = rasterizer::dilate(dilated, 2, heap);
+  int unfilled = 0, wrong = 0;
+  for (int y = 0; y < int(exact.h); y++) {
+    for (int x = 0; x < int(exact.w); x++) {
+      bool near = false;
+      for (int dy = -2; dy <= 2; dy++)
+        for (int dx = -2; dx <= 2; dx++)
+          near = near || exact.at<0>(exact.xy(x + dx, y + dy)) != 0.0f;
+      float mask = dilated.at<0>(dilated.xy(x, y));
+      unfilled += near && mask == 0.0f ? 1 : 0;
+      wrong += !near && mask != 0.0f ? 1 : 0;
+    }
+  }
+  LOGINFO(__FUNCTION__, "exact %d, conservative %d (%d missing), dilated by %d, %d unfilled, %d wrong", exactCount, conservativeCount, missing, filled,
+          unfilled, wrong);
+  if (missing || unfilled || wrong)
+    LOGERROR(__FUNCTION__, "coverage or dilation is off");
+}
+
+void testSampler() {
+  // every 16 x 16 grid of a 256 point scrambled sobol prefix holds one point per cell, the
+  // cosine hemisphere has a mean height of 2/3, and the counter hash repeats itself
+  int cells[16][16] = { };
+  for (uint32_t i = 0; i < 256; i++) {
+    Vector2 u = math::sampling::sobol(i, math::sampling::random(7, 0), math::sampling::random(7, 1));
+    cells[int(u.y * 16.0f)][int(u.x * 16.0f)]++;
+  }
+  int badCells = 0;
+  for (auto &row : cells)
+    for (int count : row)
+      badCells += count != 1 ? 1 : 0;
+
+  const int N = 1 << 20;
+  math::sampling::Pcg32 rng(42);
+  uint64_t t0 = getCounter();
+  double height = 0.0;
+  for (int i = 0; i < N; i++)
+    height += math::sampling::cosineHemisphere(Vector2(rng.uniform(), rng.uniform())).z;
+  uint64_t t1 = getCounter();
+  MTRandWrapper mtRand;
+  mtRand.seed(42);
+  int hemisphere = 0;
+  while (hemisphere < N)
+    hemisphere += math::mc::randomPointOnSphere(mtRand).z > 0.0f ? 1 : 0;
+  uint64_t t2 = getCounter();
+
+  bool repeats = math::sampling::random(123, 456) == math::sampling::random(123, 456) && math::sampling::random(123, 456) != math::sampling::random(123, 457);
+  LOGINFO(__FUNCTION__, "sobol cells off %d, mean height %f, %d directions in %.3fs (rejection sampled sphere %.3fs), counter hash %s", badCells,
+          height / double(N), N, double(t1 - t0) / double(getFreq()), double(t2 - t1) / double(getFreq()), repeats ? "repeats" : "does not repeat");
+  if (badCells || fabs(height / double(N) - 2.0 / 3.0) > 0.005 || !repeats)
+    LOGERROR(__FUNCTION__, "sampler is off");
+}
+
+void testIrradianceCache() {
+  // a record is reused close by with a similar normal, and nowhere else
+  lightmap::IrradianceCacheConfig config;
+  config.minRadius = 0.05f;
+  config.maxRadius = 1.0f;
+  lightmap::IrradianceCache cache(config);
+  lightmap::IrradianceRecord record;
+  record.p = Vector3(1.0f, 2.0f, 0.0f);
+  record.n = Vector3(0.0f, 0.0f, 1.0f);
+  record.value = Vector3(0.5f, 0.5f, 0.5f);
+  record.radius = 0.8f;
+  cache.insert(record);
+  Vector3 value;
+  bool near = cache.lookup(Vector3(1.1f, 2.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), value) && value.x == 0.5f;
+  bool far = cache.lookup(Vector3(1.5f, 2.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), value);
+  bool turned = cache.lookup(Vector3(1.0f, 2.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), value);
+  LOGINFO(__FUNCTION__, "near %s, far %s, turned %s", near ? "hit" : "miss", far ? "hit" : "miss", turned ? "hit" : "miss");
+  if (!near || far || turned)
+    LOGERROR(__FUNCTION__, "cache validity is off");
+
+  // radii left at 0 follow the scene size, set ones are kept
+  lightmap::IrradianceCacheConfig small = lightmap::IrradianceCacheConfig().sized(Vector3(3.0f, 4.0f, 0.0f));
+  lightmap::IrradianceCacheConfig large = lightmap::IrradianceCacheConfig().sized(Vector3(300.0f, 400.0f, 0.0f));
+  lightmap::IrradianceCacheConfig kept = config.sized(Vector3(300.0f, 400.0f, 0.0f));
+  LOGINFO(__FUNCTION__, "max radius %f at 5 units, %f at 500", small.maxRadius, large.maxRadius);
+  if (std::abs(large.maxRadius - 100.0f * small.maxRadius) > 1e-3f || std::abs(large.minRadius - 100.0f * small.minRadius) > 1e-3f || kept.maxRadius != 1.0f
+      || kept.minRadius != 0.05f)
+    LOGERROR(__FUNCTION__, "cache radii do not follow the scene size");
+}
+
+void testScene() {
+  // a second load shares the first one's geometry and tracers
+  std::shared_ptr<utils::heap::Heap> heap = std::make_shared<utils::heap::Heap>(64 * 1024 * 1024);
+  auto scene = scene::Scene::load(heap, "demo_scene");
+  if (!scene) {
+    LOGERROR(__FUNCTION__, "demo_scene failed to load");
+    return;
+  }
+  auto again = scene::Scene::load(heap, "demo_scene");
+  bool shared = again == scene && again->tracer(math::bpcd::TracerType::Bvh) == scene->tracer(math::bpcd::TracerType::Bvh);
+  // another lightmap size is packed, and so loaded, on its own
+  auto resized = scene::Scene::load(heap, "demo_scene", 128);
+  shared = shared && resized && resized != scene && resized->lightmapSize == 128;
+  int badIndices = 0, placed = 0;
+  size_t numVertices = 0;
+  for (const auto &mesh : scene->meshes) {
+    numVertices += mesh.vertices.size();
+    for (const auto &tri : mesh.triangles)
+      for (int j = 0; j < 3; j++)
+        badIndices += tri[j] < 0 || tri[j] >= int(mesh.vertices.size()) ? 1 : 0;
+  }
+  scene->forEachTriangle([&](int index, const scene::Vertex *v, int material) {
+    badIndices += index != placed++ || material < 0 || material >= int(scene->materials.size()) ? 1 : 0;
+  });
+  LOGINFO(__FUNCTION__, "%d triangles, %zu vertices, %s, %d bad indices", scene->numTriangles, numVertices, shared ? "shared" : "not shared", badIndices);
+  if (!shared || badIndices || placed != scene->numTriangles || numVertices >= size_t(scene->numTriangles) * 3)
+    LOGERROR(__FUNCTION__, "scene is off");
+}
+
+void testInstances() {
+  // the same grid placed three times, moved, rotated and scaled, and mirrored, traced from
+  // both sides through the top level against the placements flattened into one bvh
+  std::vector<std::array<Vector3, 3>> tris;
+  for (int i = 0; i < 64; i++) {
+    float x = float(i % 8), y = float(i / 8);
+    tris.push_back( { Vector3(x, y, 0.0f), Vector3(x + 1.0f, y, 0.0f), Vector3(x, y + 1.0f, 0.5f) });
+  }
+  auto blas = std::make_shared<math::bpcd::Bvh>();
+  blas->build(tris);
+
+  math::bpcd::Instance moved, turned;
+  moved.blas = turned.blas = blas;
+  moved.translation = Vector3(0.0f, 0.0f, 4.0f);
+  turned.linear.es[0][0] = 0.0f;
+  turned.linear.es[0][1] = -2.0f;
+  turned.linear.es[1][0] = 2.0f;
+  turned.linear.es[1][1] = 0.0f;
+  turned.translation = Vector3(20.0f, 0.0f, 1.0f);
+  turned.firstIndex = int(tris.size());
+  math::bpcd::Instance mirrored;
+  mirrored.blas = blas;
+  auto flippedBlas = std::make_shared<math::bpcd::Bvh>();
+  flippedBlas->build(math::bpcd::TriangleView(tris).flipped());
+  mirrored.mirroredBlas = flippedBlas;
+  mirrored.linear.es[0][0] = -1.0f;
+  mirrored.translation = Vector3(-1.0f, 9.0f, 2.0f);
+  mirrored.firstIndex = 2 * int(tris.size());
+  math::bpcd::InstanceBvh top( { moved, turned, mirrored });
+
+  std::vector<std::array<Vector3, 3>> flat;
+  for (auto *instance : { &moved, &turned, &mirrored })
+    for (auto &tri : tris)
+      flat.push_back( { instance->linear * tri[0] + instance->translation, instance->linear * tri[1] + instance->translation, instance->linear
+          * tri[2] + instance->translation });
+  math::bpcd::Bvh reference;
+  reference.build(flat);
+
+  math::sampling::Pcg32 rng(7);
+  int rays = 4096, mismatches = 0, hits = 0;
+  math::bpcd::RayPacket packet;
+  uint32_t expected = 0;
+  for (int i = 0; i < rays; i++) {
+    Vector3 o(rng.uniform() * 30.0f - 10.0f, rng.uniform() * 20.0f - 2.0f, 10.0f);
+    Vector3 e(rng.uniform() * 30.0f - 10.0f, rng.uniform() * 20.0f - 2.0f, -5.0f);
+    RaySeg seg = i & 1 ? RaySeg(e, o) : RaySeg(o, e);
+    math::bpcd::Trace a(seg), b(seg);
+    bool hitA = top.traceRay(seg, a), hitB = reference.traceRay(seg, b);
+    hits += hitA ? 1 : 0;
+    bool same = hitA == hitB && top.occluded(seg) == hitB;
+    if (same && hitA)
+      same = a.index == b.index && fabsf(a.raySeg.dist - b.raySeg.dist) < 1e-3f && fabsf(a.bcsCoord->x - b.bcsCoord->x) < 1e-3f
+          && fabsf(a.bcsCoord->y - b.bcsCoord->y) < 1e-3f;
+    mismatches += same ? 0 : 1;
+    expected |= hitB ? 1u << packet.size : 0u;
+    packet.push(seg);
+    if (packet.size == math::bpcd::RayPacket::maxSize) {
+      mismatches += top.occluded(packet) != expected ? 1 : 0;
+      packet.clear();
+      expected = 0;
+    }
+  }
+  LOGINFO(__FUNCTION__, "%d rays, %d hits, %d mismatches", rays, hits, mismatches);
+  if (mismatches)
+    LOGERROR(__FUNCTION__, "instanced traces are off");
+}
+
+void testBoxMips() {
+  // every level must be the 2x2 box of the one above, through the simd steps and the
+  // scalar tail alike, whether built from colors or straight from rgba
+  MTRandWrapper mt(11);
+  int w = 140, h = 72;
+  std::vector<uint8_t> rgba(size_t(w * h) * 4);
+  for (auto &byte : rgba)
+    byte = uint8_t(mt.random() * 255.0);
+  utils::img::Image fromColors, fromRGBA;
+  fromRGBA.fromRGBA(rgba.data(), w, h);
+  fromColors.w = w;
+  fromColors.h = h;
+  fromColors.pixels = fromRGBA.pixels;
+  fromColors.createMips();
+
+  int levels = 0, mismatches = 0;
+  const utils::img::Image *a = &fromColors, *b = &fromRGBA;
+  for (; a->mip && b->mip; a = a->mip.get(), b = b->mip.get(), levels++) {
+    const utils::img::Image &mip = *a->mip;
+    for (int y = 0; y < mip.h; y++)
+      for (int x = 0; x < mip.w; x++) {
+        Color box = a->sampleBox(x * 2, y * 2, 2, 2);
+        Color c = mip.get(x, y), d = b->mip->get(x, y);
+        mismatches += c.r != box.r || c.g != box.g || c.b != box.b || d.r != c.r || d.g != c.g || d.b != c.b ? 1 : 0;
+      }
+  }
+  mismatches += a->mip || b->mip ? 1 : 0;
+  LOGINFO(__FUNCTION__, "%d levels, %d mismatches", levels, mismatches);
+  if (mismatches)
+    LOGERROR(__FUNCTION__, "mips are off");
+}
@@ -1,33 +1,115 @@
-#include <cstdio>
-
-#include "file.h"
-
-namespace mbz {
-namespace utils {
-
-FileData::FileData(std::string_view fileName) {
-  FILE *fp = fopen(fileName.data(), "rb");
-  if (!fp) {
-    return;
-  }
-  fseek(fp, 0, SEEK_END);
-  auto size = ftell(fp);
-  if (!size) {
-    fclose(fp);
-    return;
-  }
-  name = fileName;
-  data = std::vector<uint8_t>(size);
-  fseek(fp, 0, SEEK_SET);
-  fread( data.data(), size, 1, fp );
-  fclose(fp);
-}
-
-void FileData::save(std::string_view fileName) {
-  FILE *fp = fopen(fileName.data(), "rb");
-  fwrite(data.data(), data.size(), 1, fp);
-  fclose(fp);
-}
-
-}
-}
+#include <cstdio>
+
+#include "file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mbz {
+namespace utils {
+
+FileData::FileData(std::string_view fileName) {
+  auto mapped = std::make_shared<MappedFile>(fileName, true);
+  if (mapped->valid()) {
+    name = fileName;
+    mapping = mapped;
+    return;
+  }
+  std::string path(fileName);
+  FILE *fp = fopen(path.c_str(), "rb");
+  if (!fp) {
+    return;
+  }
+  fseek(fp, 0, SEEK_END);
+  auto size = ftell(fp);
+  if (size <= 0) {
+    fclose(fp);
+    return;
+  }
+  name = fileName;
+  bytes = std::vector<uint8_t>(size);
+  fseek(fp, 0, SEEK_SET);
+  if (fread(bytes.data(), size, 1, fp) != 1)
+    bytes.clear();
+  fclose(fp);
+}
+
+bool FileData::save(std::string_view fileName) const {
+  std::string path(fileName);
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+  bool ok = fwrite(data(), size(), 1, fp) == 1 || empty();
+  fclose(fp);
+  return ok;
+}
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(std::string_view fileName, bool sequential) {
+  std::string path(fileName);
+  DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+  HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+    return;
+  file = handle;
+  LARGE_INTEGER length;
+  if (!GetFileSizeEx(handle, &length) || !length.QuadPart)
+    return;
+  mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+    return;
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view)
+    return;
+  name = fileName;
+  data = static_cast<const uint8_t*>(view);
+  size = size_t(length.QuadPart);
+}
+
+MappedFile::~MappedFile() {
+  if (data)
+    UnmapViewOfFile(data);
+  if (mapping)
+    CloseHandle(mapping);
+  if (file)
+    CloseHandle(file);
+}
+
+#else
+
+MappedFile::MappedFile(std::string_view fileName, bool sequential) {
+  std::string path(fileName);
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view != MAP_FAILED) {
+      if (sequential)
+        madvise(view, size_t(st.st_size), MADV_SEQUENTIAL);
+      name = fileName;
+      data = static_cast<const uint8_t*>(view);
+      size = size_t(st.st_size);
+    }
+  }
+  // the mapping keeps the file alive
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data)
+    munmap(const_cast<uint8_t*>(data), size);
+}
+
+#endif
+
+}
+}
@@ -1,19 +1,55 @@
-#pragma once
-#include <cstdint>
-#include <string>
-#include <string_view>
-#include <vector>
-
-namespace mbz {
-namespace utils {
-
-struct FileData {
-  std::string name;
-  std::vector<uint8_t> data;
-  FileData() = default;
-  FileData(std::string_view fileName);
-  void save(std::string_view fileName);
-};
-
-}
-}
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mbz {
+namespace utils {
+
+// read-only view of a whole file mapped into memory. sequential tells the os the file is
+// read front to back once, so it reads ahead and drops pages behind the reader
+struct MappedFile {
+  std::string name;
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  MappedFile(std::string_view fileName, bool sequential = false);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator =(const MappedFile&) = delete;
+  ~MappedFile();
+  bool valid() const {
+    return data != nullptr;
+  }
+#ifdef _WIN32
+ private:
+  void *file = nullptr;
+  void *mapping = nullptr;
+#endif
+};
+
+// contents of a whole file. read from disk it is a sequential mapping parsers run over in
+// place, without a copy in memory, falling back to a read when the file can't be mapped.
+// bytes holds contents built in memory for save()
+struct FileData {
+  std::string name;
+  std::vector<uint8_t> bytes;
+  FileData() = default;
+  FileData(std::string_view fileName);
+  const uint8_t* data() const {
+    return mapping ? mapping->data : bytes.data();
+  }
+  size_t size() const {
+    return mapping ? mapping->size : bytes.size();
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+  bool save(std::string_view fileName) const;
+
+ private:
+  std::shared_ptr<const MappedFile> mapping = nullptr;
+};
+
+}
+}
@@ -0,0 +1,129 @@
+#include "pool.h"
+#include "log.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace mbz {
+namespace utils {
+namespace multithread {
+
+namespace {
+
+std::mutex sharedMutex;
+PoolConfig sharedConfig;
+std::shared_ptr<Pool> sharedPool = nullptr;
+
+bool pin(std::thread &thread, int cpu) {
+#if defined(_WIN32)
+  if (cpu >= 64)
+    return false;
+  return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+}
+
+Pool::Pool(PoolConfig config) {
+  int cpus = std::max(1, int(std::thread::hardware_concurrency()));
+  int count = config.threads > 0 ? config.threads : cpus;
+  threads.reserve(count);
+  for (int i = 0; i < count; i++) {
+    threads.emplace_back([this, i]() {
+      run(i);
+    });
+    if (config.pinThreads && !pin(threads.back(), i % cpus))
+      LOGWARN("Pool::Pool()", "could not pin thread #%d", i);
+  }
+  LOGINFO("Pool::Pool()", "%d threads%s", count, config.pinThreads ? " (pinned)" : "");
+}
+
+Pool::~Pool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  queued.notify_all();
+  for (auto &thread : threads)
+    thread.join();
+}
+
+std::shared_ptr<Pool::Job> Pool::submit(std::function<void(int)> func) {
+  auto job = std::make_shared<Job>();
+  job->func = std::move(func);
+  job->pending = size();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(job);
+  }
+  queued.notify_all();
+  return job;
+}
+
+void Pool::wait(const std::shared_ptr<Job> &job) {
+  if (!job)
+    return;
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [&] {
+    return job->pending == 0;
+  });
+}
+
+void Pool::run(int id) {
+  uint64_t next = 0;
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      queued.wait(lock, [&] {
+        return stopping || next < firstJob + jobs.size();
+      });
+      if (next >= firstJob + jobs.size())
+        return;
+      job = jobs[next - firstJob];
+    }
+    job->func(id);
+    next++;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job->pending--;
+      // every thread takes the jobs in order, so they finish in order too
+      while (!jobs.empty() && jobs.front()->pending == 0) {
+        jobs.pop_front();
+        firstJob++;
+      }
+    }
+    finished.notify_all();
+  }
+}
+
+std::shared_ptr<Pool> Pool::shared() {
+  std::lock_guard<std::mutex> lock(sharedMutex);
+  if (!sharedPool)
+    sharedPool = std::make_shared<Pool>(sharedConfig);
+  return sharedPool;
+}
+
+void Pool::configure(PoolConfig config) {
+  std::lock_guard<std::mutex> lock(sharedMutex);
+  if (sharedPool)
+    LOGWARN("Pool::configure()", "shared pool already running with %d threads", sharedPool->size());
+  sharedConfig = config;
+}
+
+}
+}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+namespace mbz {
+namespace utils {
+namespace multithread {
+
+struct PoolConfig {
+  int threads = 0;  // 0 = one per hardware thread
+  bool pinThreads = false;  // pin thread i to cpu i (mod the cpu count)
+};
+
+// persistent worker threads. a job is a function every thread of the pool runs once,
+// with its thread index; jobs run in submission order, so several users can share one
+// pool and their jobs simply queue behind each other. a job must not wait on another
+// job of its own pool
+class Pool {
+ public:
+  struct Job {
+    std::function<void(int)> func;
+    int pending = 0;  // threads yet to finish it
+  };
+
+  Pool(PoolConfig config = PoolConfig());
+  Pool(const Pool&) = delete;
+  Pool& operator =(const Pool&) = delete;
+  ~Pool();
+
+  int size() const {
+    return int(threads.size());
+  }
+
+  std::shared_ptr<Job> submit(std::function<void(int)> func);
+  void wait(const std::shared_ptr<Job> &job);
+
+  // the process wide pool, created on first use with the last configuration given
+  static std::shared_ptr<Pool> shared();
+  // only takes effect when called before the first shared()
+  static void configure(PoolConfig config);
+
+ private:
+  std::vector<std::thread> threads;
+  std::deque<std::shared_ptr<Job>> jobs;
+  uint64_t firstJob = 0;  // sequence number of jobs.front()
+  bool stopping = false;
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable finished;
+
+  void run(int id);
+};
+
+}
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mbz {
+namespace utils {
+
+// non-owning view of a contiguous run of elements, e.g. a vector's contents or part of
+// a mapped file
+template<typename T>
+struct Span {
+  T *p = nullptr;
+  size_t n = 0;
+
+  Span() = default;
+  Span(T *p_, size_t n_)
+      :
+      p(p_),
+      n(n_) {
+  }
+  template<typename Container>
+  Span(Container &container)
+      :
+      p(container.data()),
+      n(container.size()) {
+  }
+
+  T& operator[](size_t i) const {
+    return p[i];
+  }
+  T* data() const {
+    return p;
+  }
+  size_t size() const {
+    return n;
+  }
+  bool empty() const {
+    return n == 0;
+  }
+  T* begin() const {
+    return p;
+  }
+  T* end() const {
+    return p + n;
+  }
+};
+
+}
+}
@@ -1,137 +1,226 @@
-#pragma once
-
-#include "log.h"
-#include "heap.h"
-#include <vector>
-#include <mutex>
-#include <thread>
-#include <condition_variable>
-#include <string>
-#include <string_view>
-#include <memory>
-
-#include "array.h"
-
-extern uint64_t getCounter();
-extern uint64_t getFreq();
-
-namespace mbz {
-namespace utils {
-namespace multithread {
-
-struct Toolbox {
-  virtual ~Toolbox() = default;
-};
-
-struct Task {
-  virtual void perform(Toolbox *toolbox) = 0;
-  virtual ~Task() = default;
-};
-
-template<int N>
-class Workers {
-  std::array<std::thread, N> workers;
-
-  std::mutex mutex;
-  std::condition_variable condition;
-  int tasksPer;
-
- public:
-  std::mutex todoMutex;
-  std::mutex completedMutex;
-
-  volatile bool start = false;
-  utils::heap::Array<std::unique_ptr<Task>> todo;
-  utils::heap::Array<std::unique_ptr<Task>> completed;
-
-  virtual std::unique_ptr<Toolbox> divyToolbox(int workerId) {
-    return std::make_unique<Toolbox>();
-  }
-  Workers(std::shared_ptr<heap::Heap> heap, uint32_t taskCount, int tasksPer_ = 1)
-      :
-      tasksPer(tasksPer_),
-      todo(heap, taskCount, heap::Growth::Fixed),
-      completed(heap, taskCount, heap::Growth::Fixed) {
-    auto work = [&](int id) {
-      {
-        std::unique_lock<std::mutex> lock(mutex);
-        this->condition.wait(lock, [&] {
-          return this->start;
-        });
-      }
-      //std::string id;
-      //std::stringstream ss;
-      //ss << std::this_thread::get_id();
-      //ss >> id;
-      bool run = true;
-      std::vector<std::unique_ptr<Task>> tasks;
-
-      auto toolbox = divyToolbox(id);
-      LOGINFO("Workers::work", "worker #%d started...", id);
-      while (run) {
-        {
-          std::lock_guard<std::mutex> lg(todoMutex);
-          if (todo.size) {
-            for (int i = 0; i < tasksPer; i++) {
-              tasks.push_back(std::move(todo.p()[todo.size - 1]));
-              todo.size--;
-              if (todo.size == 0)
-                break;
-            }
-            LOGINFO("Workers::Workers::work", "grabbed %zu tasks (%d remain)", tasks.size(), todo.size);
-
-          }
-          run = todo.size > 0;
-        }
-
-        if (!tasks.empty()) {
-          for (auto &task : tasks) {
-            task->perform(toolbox.get());
-          }
-          {
-            std::lock_guard<std::mutex> lg(completedMutex);
-            for (auto &task : tasks)
-              completed.append_move(std::move(task));
-          }
-          tasks.clear();
-        }
-      }
-      LOGINFO("Workers::Workers::work", "worker #%d finished!", id);
-    };
-
-    int index = 0;
-    for (auto &worker : workers) {
-      worker = std::thread([work, index]() {
-        work(index);
-      });
-      index++;
-    }
-  }
-
-  void join() {
-    for (std::thread &worker : workers)
-      if (worker.joinable())
-        worker.join();
-  }
-
-  void begin() {
-    std::lock_guard<std::mutex> lock(mutex);
-    start = true;
-    condition.notify_all();
-  }
-
-  void beginJoin() {
-    begin();
-    join();
-  }
-
-  ~Workers() {
-    join();
-  }
-
-}
-;
-
-}
-}
-}
+#pragma once
+
+#include "log.h"
+#include "heap.h"
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <algorithm>
+
+#include "array.h"
+#include "pool.h"
+
+extern uint64_t getCounter();
+extern uint64_t getFreq();
+
+namespace mbz {
+namespace utils {
+namespace multithread {
+
+struct Toolbox {
+  virtual ~Toolbox() = default;
+};
+
+struct Task {
+  virtual void perform(Toolbox *toolbox) = 0;
+  virtual ~Task() = default;
+};
+
+// chase-lev deque of tasks (with the memory orders of le et al.). the owning worker
+// pushes and pops at the bottom, other workers steal from the top
+class WorkDeque {
+  std::atomic<int64_t> top { 0 };
+  std::atomic<int64_t> bottom { 0 };
+  std::vector<std::atomic<Task*>> buffer;
+  int64_t mask = 0;
+
+ public:
+  // sizes the ring for at most capacity tasks at once, only while no one else touches it
+  void reserve(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    buffer = std::vector<std::atomic<Task*>>(size);
+    mask = int64_t(size) - 1;
+    top.store(0, std::memory_order_relaxed);
+    bottom.store(0, std::memory_order_relaxed);
+  }
+
+  // owner only
+  void push(Task *task) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    buffer[b & mask].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // owner only, nullptr once empty
+  Task* pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    Task *task = nullptr;
+    if (t <= b) {
+      task = buffer[b & mask].load(std::memory_order_relaxed);
+      if (t == b) {
+        // last task, race the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+          task = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // any thread. nullptr either when empty is set or when another thread won the task
+  Task* steal(bool &empty) {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    empty = t >= b;
+    if (empty)
+      return nullptr;
+    Task *task = buffer[t & mask].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      return nullptr;
+    return task;
+  }
+};
+
+// runs the tasks queued in todo on the threads of a pool once begun. todo is dealt out to
+// one deque per pool thread in runs of tasksPer, so neighbouring tasks stay on one thread,
+// and threads that run dry steal from random others. finished tasks collect per thread
+// and are moved to completed by join(), after which todo can be filled and begun again
+class Workers {
+  std::shared_ptr<Pool> pool;
+  std::shared_ptr<Pool::Job> job = nullptr;
+  int numWorkers;
+  std::vector<WorkDeque> deques;
+  std::vector<std::vector<std::unique_ptr<Task>>> done;
+  int tasksPer;
+
+  // deals todo out to the deques, before any worker starts
+  void deal() {
+    std::lock_guard<std::mutex> lg(todoMutex);
+    int runs = (todo.size + tasksPer - 1) / tasksPer;
+    for (int i = 0; i < numWorkers; i++) {
+      int count = 0;
+      for (int run = i; run < runs; run += numWorkers)
+        count += std::min(tasksPer, todo.size - run * tasksPer);
+      deques[i].reserve(size_t(count));
+      done[i].reserve(size_t(count));
+    }
+    // pushed back to front so each worker pops its runs in queue order
+    for (int run = runs - 1; run >= 0; run--) {
+      int first = run * tasksPer;
+      int last = std::min(todo.size, first + tasksPer);
+      for (int k = last - 1; k >= first; k--)
+        deques[run % numWorkers].push(todo.p()[k].release());
+    }
+    todo.size = 0;
+  }
+
+  void work(int id) {
+    auto toolbox = divyToolbox(id);
+    LOGDEBUG("Workers::work", "worker #%d started...", id);
+    uint32_t seed = 2654435761u * uint32_t(id + 1);
+    while (true) {
+      Task *task = deques[id].pop();
+      // nothing is queued once the workers run, so when every other deque has been
+      // seen empty there is nothing left to steal
+      for (int tries = 0; !task && numWorkers > 1 && tries < 4 * numWorkers; tries++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        int victim = int(seed % uint32_t(numWorkers));
+        bool empty = false;
+        if (victim != id)
+          task = deques[victim].steal(empty);
+      }
+      if (!task) {
+        for (int victim = 0; !task && victim < numWorkers; victim++) {
+          bool empty = false;
+          while (!task && !empty && victim != id)
+            task = deques[victim].steal(empty);
+        }
+      }
+      if (!task)
+        break;
+      task->perform(toolbox.get());
+      done[id].emplace_back(task);
+    }
+    LOGDEBUG("Workers::work", "worker #%d finished! (%zu tasks)", id, done[id].size());
+  }
+
+ public:
+  std::mutex todoMutex;
+  std::mutex completedMutex;
+
+  utils::heap::Array<std::unique_ptr<Task>> todo;
+  utils::heap::Array<std::unique_ptr<Task>> completed;
+
+  // called on each pool thread at the start of every run
+  virtual std::unique_ptr<Toolbox> divyToolbox(int workerId) {
+    return std::make_unique<Toolbox>();
+  }
+  Workers(std::shared_ptr<heap::Heap> heap, uint32_t taskCount, int tasksPer_ = 1, std::shared_ptr<Pool> pool_ = nullptr)
+      :
+      pool(pool_ ? pool_ : Pool::shared()),
+      numWorkers(pool->size()),
+      deques(numWorkers),
+      done(numWorkers),
+      tasksPer(std::max(1, tasksPer_)),
+      todo(heap, taskCount, heap::Growth::Fixed),
+      completed(heap, taskCount, heap::Growth::Fixed) {
+  }
+  Workers(const Workers&) = delete;
+  Workers& operator =(const Workers&) = delete;
+
+  int size() const {
+    return numWorkers;
+  }
+
+  void join() {
+    if (!job)
+      return;
+    pool->wait(job);
+    job = nullptr;
+    std::lock_guard<std::mutex> lg(completedMutex);
+    for (auto &tasks : done) {
+      for (auto &task : tasks)
+        completed.append_move(std::move(task));
+      tasks.clear();
+    }
+  }
+
+  void begin() {
+    join();
+    deal();
+    job = pool->submit([this](int id) {
+      work(id);
+    });
+  }
+
+  void beginJoin() {
+    begin();
+    join();
+  }
+
+  virtual ~Workers() {
+    join();
+  }
+
+};
+
+}
+}
+}